@@ -6,7 +6,11 @@
 
 #include <KRunner/Action>
 #include <KRunner/RunnerManager>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QFile>
 #include <QObject>
+#include <QPointer>
 #include <QProcess>
 #include <QSignalSpy>
 #include <QStandardPaths>
@@ -41,6 +45,16 @@ private Q_SLOTS:
     void testIconData();
     void testLifecycleMethods();
     void testRequestActionsWildcards();
+    void testWildcardDeadline();
+    void testServiceQuarantine();
+    void testStreamingMatches();
+    void testCancelStreamingMatches();
+    void testMatchKRunner2();
+    void testIconHandles();
+    void testPeerConnection();
+    void testConfigCache();
+    void testMatchHints();
+    void testMatchHintsMultipleServices();
 };
 
 DBusRunnerTest::DBusRunnerTest()
@@ -56,6 +70,7 @@ void DBusRunnerTest::cleanup()
 {
     // Make sure kill the running processes after each test
     killRunningDBusProcesses();
+    QFile::remove(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/krunnerdbusrunnercache"));
 }
 
 void DBusRunnerTest::testMatch()
@@ -67,6 +82,8 @@ void DBusRunnerTest::testMatch()
     // verify matches
     QCOMPARE(matches.count(), 1);
     auto result = matches.first();
+    // The replies are converted on the thread shared by the DBus runners
+    QVERIFY(result.runner()->thread() != manager->thread());
 
     // see testremoterunner.cpp
     QCOMPARE(result.id(), QStringLiteral("dbusrunnertest_id1")); // note the runner name is prepended
@@ -183,6 +200,19 @@ void DBusRunnerTest::testIconData()
 
     QCOMPARE(result.icon().availableSizes().first(), QSize(10, 10));
     QCOMPARE(result.icon().pixmap(QSize(10, 10)), QPixmap::fromImage(expectedIcon));
+
+    // The same icon data is only decoded once
+    const auto newMatches = launchQuery(QStringLiteral("fooCostomIcon2"));
+    QCOMPARE(newMatches.count(), 1);
+    QCOMPARE(newMatches.first().icon().cacheKey(), result.icon().cacheKey());
+
+    // 16 bit channels are supported too
+    const auto wideMatches = launchQuery(QStringLiteral("fooCostomIconRgba64"));
+    QCOMPARE(wideMatches.count(), 1);
+    const QImage wideIcon = wideMatches.first().icon().pixmap(QSize(10, 10)).toImage();
+    QCOMPARE(wideIcon.size(), QSize(10, 10));
+    QCOMPARE(wideIcon.pixelColor(5, 5).blue(), 255);
+    QVERIFY(qAbs(wideIcon.pixelColor(5, 5).alpha() - 128) <= 1);
 }
 
 void DBusRunnerTest::testLifecycleMethods()
@@ -235,6 +265,237 @@ void DBusRunnerTest::testRequestActionsWildcards()
     QCOMPARE(matches.at(0).actions(), matches.at(1).actions());
 }
 
+void DBusRunnerTest::testWildcardDeadline()
+{
+    startDBusRunnerProcess({QStringLiteral("net.krunnertests.multi.a1")}, QStringLiteral("net.krunnertests.multi.a1"));
+    startDBusRunnerProcess({QStringLiteral("net.krunnertests.multi.slow")}, QStringLiteral("net.krunnertests.multi.slow"));
+    manager = std::make_unique<RunnerManager>(); // This case is special, because we want to load the runners manually
+    manager->loadRunner(parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestmulti.desktop")));
+
+    // The slow service does not reply before we release it, the query finishes after the deadline without it
+    const auto matches = launchQuery(QStringLiteral("fooDeadline"));
+    QCOMPARE(matches.count(), 1);
+    QCOMPARE(matches.constFirst().data().toList().constFirst().toString(), QStringLiteral("net.krunnertests.multi.a1"));
+
+    // Its late match is still added
+    auto releaseMethod = QDBusMessage::createMethodCall(QStringLiteral("net.krunnertests.multi.slow"),
+                                                        QStringLiteral("/dave"),
+                                                        QStringLiteral("org.kde.krunner1"),
+                                                        QStringLiteral("Run"));
+    releaseMethod.setArguments({QStringLiteral("release"), QString()});
+    QDBusConnection::sessionBus().asyncCall(releaseMethod);
+    QTRY_COMPARE(manager->matches().count(), 2);
+}
+
+void DBusRunnerTest::testServiceQuarantine()
+{
+    QProcess *process = startDBusRunnerProcess({QStringLiteral("net.krunnertests.multi.a1")}, QStringLiteral("net.krunnertests.multi.a1"));
+    QProcess *slowProcess = startDBusRunnerProcess({QStringLiteral("net.krunnertests.multi.slow")}, QStringLiteral("net.krunnertests.multi.slow"));
+    manager = std::make_unique<RunnerManager>(); // This case is special, because we want to load the runners manually
+    manager->loadRunner(parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestmulti.desktop")));
+
+    // The slow service is never released, it misses the deadline of every query
+    QByteArray output;
+    QByteArray slowOutput;
+    for (int i = 1; i <= 3; ++i) {
+        const QString query = QStringLiteral("fooDeadline%1").arg(i);
+        QCOMPARE(launchQuery(query).count(), 1);
+        QTRY_VERIFY((slowOutput += slowProcess->readAllStandardOutput()).contains("Matching:" + query.toUtf8()));
+    }
+
+    // After missing it three times in a row, it is no longer queried
+    QCOMPARE(launchQuery(QStringLiteral("fooDeadline4")).count(), 1);
+    QTRY_VERIFY((output += process->readAllStandardOutput()).contains("Matching:fooDeadline4"));
+    QVERIFY(!(slowOutput += slowProcess->readAllStandardOutput()).contains("Matching:fooDeadline4"));
+}
+
+void DBusRunnerTest::testStreamingMatches()
+{
+    startDBusRunnerProcess({QStringLiteral("net.krunnertests.dave")});
+    manager = std::make_unique<RunnerManager>(); // This case is special, because we want to load the runners manually
+    auto md = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestkrunner2.desktop"));
+    manager->loadRunner(md);
+    QCOMPARE(manager->runners().count(), 1);
+
+    QSignalSpy queryFinishedSpy(manager.get(), &RunnerManager::queryFinished);
+    manager->launchQuery(QStringLiteral("fooStream"));
+
+    // The first match is shown before the remote runner finished the query
+    QTRY_COMPARE_WITH_TIMEOUT(manager->matches().count(), 1, 2000);
+    QCOMPARE(manager->matches().constFirst().text(), QStringLiteral("Match 1"));
+    QVERIFY(queryFinishedSpy.isEmpty());
+
+    QVERIFY(queryFinishedSpy.wait());
+    const auto matches = manager->matches();
+    QCOMPARE(matches.count(), 2);
+    QCOMPARE(matches.at(1).text(), QStringLiteral("Match 2"));
+    QCOMPARE(matches.at(1).data().toList().constFirst().toString(), QStringLiteral("net.krunnertests.dave"));
+
+    // Runners that do not stream their matches are still supported through the same interface
+    QCOMPARE(launchQuery(QStringLiteral("fooo")).count(), 1);
+}
+
+void DBusRunnerTest::testCancelStreamingMatches()
+{
+    QProcess *process = startDBusRunnerProcess({QStringLiteral("net.krunnertests.dave")});
+    manager = std::make_unique<RunnerManager>(); // This case is special, because we want to load the runners manually
+    auto md = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestkrunner2.desktop"));
+    manager->loadRunner(md);
+
+    manager->launchQuery(QStringLiteral("fooStream"));
+    QTRY_COMPARE_WITH_TIMEOUT(manager->matches().count(), 1, 2000);
+
+    // Resetting the context cancels the query, the second match is never reported
+    manager->reset();
+    QTRY_VERIFY_WITH_TIMEOUT(process->readAllStandardOutput().contains("Cancel"), 2000);
+    QTest::qWait(700);
+    QVERIFY(manager->matches().isEmpty());
+}
+
+void DBusRunnerTest::testMatchKRunner2()
+{
+    QProcess *process = startDBusRunnerProcess({QStringLiteral("net.krunnertests.dave")});
+    manager = std::make_unique<RunnerManager>(); // This case is special, because we want to load the runners manually
+    auto md = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestkrunner2.desktop"));
+    manager->loadRunner(md);
+    QCOMPARE(manager->runners().count(), 1);
+
+    const auto matches = launchQuery(QStringLiteral("fooo"));
+    QCOMPARE(matches.count(), 1);
+    const auto result = matches.first();
+    QCOMPARE(result.id(), QStringLiteral("dbusrunnertest_id1"));
+    QCOMPARE(result.text(), QStringLiteral("Match 1"));
+    QCOMPARE(result.iconName(), QStringLiteral("icon1"));
+    QCOMPARE(result.categoryRelevance(), qToUnderlying(KRunner::QueryMatch::CategoryRelevance::Highest));
+    QCOMPARE(result.isMultiLine(), true);
+    QCOMPARE(result.actions().size(), 1);
+
+    QSignalSpy processSpy(process, &QProcess::readyRead);
+    manager->run(result, result.actions().constFirst());
+    processSpy.wait();
+    QCOMPARE(process->readAllStandardOutput().trimmed().split('\n').constLast(), QByteArray("Running:id1:action1"));
+
+    const auto iconMatches = launchQuery(QStringLiteral("fooCostomIcon"));
+    QCOMPARE(iconMatches.count(), 1);
+    QCOMPARE(iconMatches.first().icon().availableSizes().first(), QSize(10, 10));
+}
+
+void DBusRunnerTest::testIconHandles()
+{
+    if (!(QDBusConnection::sessionBus().connectionCapabilities() & QDBusConnection::UnixFileDescriptorPassing)) {
+        QSKIP("The session bus does not support file descriptor passing");
+    }
+    QProcess *process = startDBusRunnerProcess({QStringLiteral("net.krunnertests.dave")});
+    manager = std::make_unique<RunnerManager>();
+    auto md = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestkrunner2.desktop"));
+    manager->loadRunner(md);
+
+    auto matches = launchQuery(QStringLiteral("fooIconHandle"));
+    QCOMPARE(matches.count(), 2);
+    QVERIFY(matches.at(0).iconName().isEmpty());
+    QCOMPARE(matches.at(0).icon().availableSizes().first(), QSize(16, 16));
+    // Both matches share one decoded icon
+    QCOMPARE(matches.at(0).icon().cacheKey(), matches.at(1).icon().cacheKey());
+    QVERIFY(process->readAllStandardOutput().contains("GetIcons:blue"));
+
+    // The handle is already known, it is not requested again
+    matches = launchQuery(QStringLiteral("fooIconHandle2"));
+    QCOMPARE(matches.count(), 2);
+    QCOMPARE(matches.at(0).icon().availableSizes().first(), QSize(16, 16));
+    QVERIFY(!process->readAllStandardOutput().contains("GetIcons"));
+
+    // An icon whose file is not sealed is copied instead of mapped, the runner truncating it afterwards does not crash us
+    matches = launchQuery(QStringLiteral("fooIconUnsealed"));
+    QCOMPARE(matches.count(), 1);
+    QVERIFY(process->readAllStandardOutput().contains("GetIcons:red"));
+    QVERIFY(matches.at(0).iconName().isEmpty());
+    QCOMPARE(matches.at(0).icon().availableSizes().first(), QSize(16, 16));
+}
+
+void DBusRunnerTest::testPeerConnection()
+{
+    QProcess *process = startDBusRunnerProcess({QStringLiteral("net.krunnertests.dave")});
+    manager = std::make_unique<RunnerManager>();
+    auto md = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestkrunner2.desktop"));
+    manager->loadRunner(md);
+
+    // The runner advertises a peer address in its config. The connection is set up in the background,
+    // until then the session bus is used
+    QByteArray output;
+    for (int i = 0; i < 10 && !output.contains("StartMatch:peer"); ++i) {
+        const auto matches = launchQuery(QStringLiteral("fooo"));
+        QCOMPARE(matches.count(), 1);
+        QCOMPARE(matches.first().text(), QStringLiteral("Match 1"));
+        output = process->readAllStandardOutput();
+    }
+    QVERIFY(output.contains("StartMatch:peer"));
+
+    // Another RunnerManager with the same runner gets its own connection, which is closed independently
+    {
+        RunnerManager otherManager;
+        otherManager.loadRunner(md);
+        QSignalSpy queryFinishedSpy(&otherManager, &RunnerManager::queryFinished);
+        otherManager.launchQuery(QStringLiteral("fooo"));
+        QVERIFY(queryFinishedSpy.wait());
+        QCOMPARE(otherManager.matches().count(), 1);
+    }
+    process->readAllStandardOutput();
+
+    // Once connected, all matching happens through it
+    QCOMPARE(launchQuery(QStringLiteral("fooo")).count(), 1);
+    output = process->readAllStandardOutput();
+    QVERIFY(output.contains("StartMatch:peer"));
+    QVERIFY(!output.contains("StartMatch:bus"));
+}
+
+void DBusRunnerTest::testConfigCache()
+{
+    startDBusRunnerProcess({QStringLiteral("net.krunnertests.dave")});
+    const auto md = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestkrunner2.desktop"));
+    manager = std::make_unique<RunnerManager>();
+    const QPointer<AbstractRunner> oldRunner = manager->loadRunner(md);
+    QCOMPARE(launchQuery(QStringLiteral("fooo")).count(), 1);
+    manager.reset(); // Make sure the runner and its thread are gone
+    QVERIFY(oldRunner.isNull());
+
+    // The runner provides a CacheKey, its config and actions are used without it being around
+    killRunningDBusProcesses();
+    manager = std::make_unique<RunnerManager>();
+    AbstractRunner *runner = manager->loadRunner(md);
+    QTRY_COMPARE(runner->minLetterCount(), 4);
+    QVERIFY(runner->hasMatchRegex());
+    QCOMPARE(runner->matchRegex().pattern(), QStringLiteral("^fo"));
+}
+
+void DBusRunnerTest::testMatchHints()
+{
+    QProcess *process = startDBusRunnerProcess({QStringLiteral("net.krunnertests.dave")});
+    manager = std::make_unique<RunnerManager>();
+    manager->loadRunner(parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestkrunner2.desktop")));
+
+    launchQuery(QStringLiteral("fooo"));
+    QVERIFY(process->readAllStandardOutput().contains("Hints::0"));
+    // The previous query of the session is passed along
+    launchQuery(QStringLiteral("foooo"), QStringLiteral("dbusrunnertest"));
+    QVERIFY(process->readAllStandardOutput().contains("Hints:fooo:1"));
+}
+
+void DBusRunnerTest::testMatchHintsMultipleServices()
+{
+    QProcess *process1 = startDBusRunnerProcess({QStringLiteral("net.krunnertests.multi.a1")}, QStringLiteral("net.krunnertests.multi.a1"));
+    QProcess *process2 = startDBusRunnerProcess({QStringLiteral("net.krunnertests.multi.a2")}, QStringLiteral("net.krunnertests.multi.a2"));
+    manager = std::make_unique<RunnerManager>();
+    manager->loadRunner(parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/dbusrunnertestmultikrunner2.desktop")));
+
+    QCOMPARE(launchQuery(QStringLiteral("fooo")).count(), 2);
+    process1->readAllStandardOutput();
+    process2->readAllStandardOutput();
+    // Every service gets the previous query, not just the first one that is asked
+    QCOMPARE(launchQuery(QStringLiteral("foooo")).count(), 2);
+    QVERIFY(process1->readAllStandardOutput().contains("Hints:fooo:0"));
+    QVERIFY(process2->readAllStandardOutput().contains("Hints:fooo:0"));
+}
+
 QTEST_MAIN(DBusRunnerTest)
 
 #include "dbusrunnertest.moc"
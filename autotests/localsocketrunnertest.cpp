@@ -0,0 +1,150 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <KRunner/RunnerManager>
+#include <QObject>
+#include <QProcess>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <memory>
+
+#include "kpluginmetadata_utils_p.h"
+
+using namespace KRunner;
+
+class LocalSocketRunnerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void testMatch();
+    void testConnectionReuse();
+    void testCancel();
+    void testServerRestart();
+
+private:
+    void startServer();
+    QList<QueryMatch> launchQuery(const QString &query);
+
+    std::unique_ptr<QProcess> m_process;
+    std::unique_ptr<RunnerManager> m_manager;
+};
+
+void LocalSocketRunnerTest::startServer()
+{
+    m_process = std::make_unique<QProcess>();
+    // Same lookup as the runner for relative socket names
+    const QString socketName = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + QLatin1String("/krunnertests-localsocket");
+    m_process->start(QStringLiteral(KRUNNER_TEST_LOCALSOCKET_EXECUTABLE), {socketName});
+    QVERIFY(m_process->waitForStarted());
+    QTRY_VERIFY_WITH_TIMEOUT(m_process->readLine().trimmed() == "Listening", 5000);
+}
+
+QList<QueryMatch> LocalSocketRunnerTest::launchQuery(const QString &query)
+{
+    QSignalSpy spy(m_manager.get(), &RunnerManager::queryFinished);
+    m_manager->launchQuery(query);
+    if (!QTest::qVerify(spy.wait(), "spy.wait()", "RunnerManager did not emit the queryFinished signal", __FILE__, __LINE__)) {
+        return {};
+    }
+    return m_manager->matches();
+}
+
+void LocalSocketRunnerTest::init()
+{
+    startServer();
+    m_manager = std::make_unique<RunnerManager>();
+    const auto md = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/localsocketrunnertest.desktop"));
+    QVERIFY(md.isValid());
+    m_manager->loadRunner(md);
+    QCOMPARE(m_manager->runners().count(), 1);
+}
+
+void LocalSocketRunnerTest::cleanup()
+{
+    m_manager.reset();
+    if (m_process) {
+        m_process->kill();
+        m_process->waitForFinished();
+        m_process.reset();
+    }
+}
+
+void LocalSocketRunnerTest::testMatch()
+{
+    const auto matches = launchQuery(QStringLiteral("foo"));
+    QCOMPARE(matches.count(), 1);
+    const QueryMatch result = matches.constFirst();
+    // The socket is read on the thread shared by the remote runners
+    QVERIFY(result.runner()->thread() != m_manager->thread());
+
+    // see testlocalsocketrunner.cpp
+    QCOMPARE(result.id(), QStringLiteral("localsocketrunnertest_id1"));
+    QCOMPARE(result.text(), QStringLiteral("Match 1"));
+    QCOMPARE(result.iconName(), QStringLiteral("icon1"));
+    QCOMPARE(result.categoryRelevance(), qToUnderlying(QueryMatch::CategoryRelevance::Highest));
+    QCOMPARE(result.isMultiLine(), true);
+    QCOMPARE(result.runner()->syntaxes().count(), 2);
+
+    m_manager->run(result);
+    QTRY_VERIFY_WITH_TIMEOUT(m_process->readAllStandardOutput().contains("Running:id1"), 2000);
+
+    QVERIFY(launchQuery(QStringLiteral("bar")).isEmpty());
+}
+
+void LocalSocketRunnerTest::testConnectionReuse()
+{
+    QCOMPARE(launchQuery(QStringLiteral("foo")).count(), 1);
+    QCOMPARE(launchQuery(QStringLiteral("fooo")).count(), 1);
+    QCOMPARE(launchQuery(QStringLiteral("foooo")).count(), 1);
+
+    const QByteArray output = m_process->readAllStandardOutput();
+    QCOMPARE(output.count("Connected"), 1);
+    QCOMPARE(output.count("Matching:"), 3);
+}
+
+void LocalSocketRunnerTest::testCancel()
+{
+    QSignalSpy queryFinishedSpy(m_manager.get(), &RunnerManager::queryFinished);
+    m_manager->launchQuery(QStringLiteral("fooStream"));
+    QTRY_COMPARE_WITH_TIMEOUT(m_manager->matches().count(), 1, 2000);
+    QVERIFY(queryFinishedSpy.isEmpty());
+
+    // Resetting the context cancels the query on the other side
+    m_manager->reset();
+    QTRY_VERIFY_WITH_TIMEOUT(m_process->readAllStandardOutput().contains("Cancel:1"), 2000);
+    QVERIFY(m_manager->matches().isEmpty());
+
+    // The connection stays usable for the next query
+    QCOMPARE(launchQuery(QStringLiteral("foo")).count(), 1);
+}
+
+void LocalSocketRunnerTest::testServerRestart()
+{
+    QSignalSpy queryFinishedSpy(m_manager.get(), &RunnerManager::queryFinished);
+    m_manager->launchQuery(QStringLiteral("fooStream"));
+    QTRY_COMPARE_WITH_TIMEOUT(m_manager->matches().count(), 1, 2000);
+
+    // Pending queries are finished when the connection is lost
+    m_process->kill();
+    m_process->waitForFinished();
+    QVERIFY(queryFinishedSpy.wait());
+
+    // Running a match connects again, the request is sent once the connection is established
+    const QueryMatch match = m_manager->matches().constFirst();
+    startServer();
+    m_manager->run(match);
+    QTRY_VERIFY_WITH_TIMEOUT(m_process->readAllStandardOutput().contains("Running:id1"), 2000);
+    QCOMPARE(launchQuery(QStringLiteral("foo")).count(), 1);
+}
+
+QTEST_MAIN(LocalSocketRunnerTest)
+
+#include "localsocketrunnertest.moc"
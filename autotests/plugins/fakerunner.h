@@ -32,6 +32,30 @@ public:
             context.addMatch(createDummyMatch(QStringLiteral("foo"), 0.1));
             context.addMatch(createDummyMatch(QStringLiteral("bar"), 0.2));
         }
+        if (context.query().startsWith(QLatin1String("tie"))) {
+            context.addMatches({createDummyMatch(QStringLiteral("alpha"), 0.5),
+                                createDummyMatch(QStringLiteral("gamma"), 0.9),
+                                createDummyMatch(QStringLiteral("beta"), 0.5)});
+        }
+        if (context.query().startsWith(QLatin1String("duplicates"))) {
+            // Runners without unique results may use the same id for several matches
+            QList<QueryMatch> matches{createDummyMatch(QStringLiteral("first"), 0.5), createDummyMatch(QStringLiteral("second"), 0.4)};
+            for (QueryMatch &match : matches) {
+                match.setId(QStringLiteral("duplicate"));
+                match.setSubtext(context.query());
+            }
+            context.addMatches(matches);
+        }
+        if (context.query().startsWith(QLatin1String("categories"))) {
+            QList<QueryMatch> matches;
+            for (int i = 0; i < 12; ++i) {
+                QueryMatch match = createDummyMatch(QStringLiteral("match%1").arg(i), 0.1 * (i % 5));
+                match.setMatchCategory(QStringLiteral("category%1").arg(i % 3));
+                match.setCategoryRelevance(i % 3 ? QueryMatch::CategoryRelevance::Moderate : QueryMatch::CategoryRelevance::Highest);
+                matches << match;
+            }
+            context.addMatches(matches);
+        }
     }
 
 private:
@@ -0,0 +1,93 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include <iostream>
+#include <memory>
+
+#include "../src/localsocketprotocol_p.h"
+
+using namespace KRunner::LocalSocketProtocol;
+
+// Test runner for X-Plasma-API=LocalSocket, if the search term contains "foo" it returns a match, otherwise nothing.
+// Queries starting with "fooStream" get one match and are only finished when KRunner cancels them.
+// New connections, cancellations and Run print a line to stdout
+
+static void handleFrame(QLocalSocket *socket, const QByteArray &payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint8 type = 0;
+    stream >> type;
+
+    switch (MessageType(type)) {
+    case MessageType::Match: {
+        quint32 queryId = 0;
+        QString query;
+        stream >> queryId >> query;
+        std::cout << "Matching:" << qPrintable(query) << std::endl;
+        if (query.contains(QLatin1String("foo"))) {
+            Match match;
+            match.id = QStringLiteral("id1");
+            match.text = QStringLiteral("Match 1");
+            match.iconName = QStringLiteral("icon1");
+            match.relevance = 0.8;
+            match.categoryRelevance = 100;
+            match.multiLine = true;
+            socket->write(frame(MessageType::MatchesAvailable, queryId, QList<Match>{match}));
+        }
+        if (!query.startsWith(QLatin1String("fooStream"))) {
+            socket->write(frame(MessageType::MatchFinished, queryId));
+        }
+        break;
+    }
+    case MessageType::Cancel: {
+        quint32 queryId = 0;
+        stream >> queryId;
+        std::cout << "Cancel:" << queryId << std::endl;
+        break;
+    }
+    case MessageType::Run: {
+        QString matchId;
+        stream >> matchId;
+        std::cout << "Running:" << qPrintable(matchId) << std::endl;
+        break;
+    }
+    default:
+        socket->abort();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    const auto arguments = app.arguments();
+    Q_ASSERT(arguments.count() == 2);
+
+    QLocalServer::removeServer(arguments[1]);
+    QLocalServer server;
+    QObject::connect(&server, &QLocalServer::newConnection, &server, [&server]() {
+        while (QLocalSocket *socket = server.nextPendingConnection()) {
+            std::cout << "Connected" << std::endl;
+            auto buffer = std::make_shared<QByteArray>();
+            QObject::connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+            QObject::connect(socket, &QLocalSocket::readyRead, socket, [socket, buffer]() {
+                buffer->append(socket->readAll());
+                QByteArray payload;
+                while (takeFrame(*buffer, payload) == FrameResult::Complete) {
+                    handleFrame(socket, payload);
+                }
+            });
+        }
+    });
+    const bool listening = server.listen(arguments[1]);
+    Q_ASSERT(listening);
+    std::cout << "Listening" << std::endl;
+    app.exec();
+}
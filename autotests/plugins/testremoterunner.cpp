@@ -8,28 +8,44 @@
 
 #include <QCoreApplication>
 #include <QDBusConnection>
+#include <QDBusServer>
 #include <QImage>
+#include <QTimer>
+#include <QtEndian>
 
 #include <iostream>
 
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#endif
+
 #include "krunner1adaptor.h"
+#include "krunner2adaptor.h"
 
 // Test DBus runner, if the search term contains "foo" it returns a match, otherwise nothing
 // Run prints a line to stdout
 
 TestRemoteRunner::TestRemoteRunner(const QString &serviceName, bool showLifecycleMethodCalls)
+    : m_serviceName(serviceName)
 {
     new Krunner1Adaptor(this);
     qDBusRegisterMetaType<RemoteMatch>();
     qDBusRegisterMetaType<RemoteMatches>();
+    qDBusRegisterMetaType<RemoteMatch2>();
+    qDBusRegisterMetaType<RemoteMatches2>();
     qDBusRegisterMetaType<KRunner::Action>();
     qDBusRegisterMetaType<KRunner::Actions>();
     qDBusRegisterMetaType<RemoteImage>();
+    qDBusRegisterMetaType<RemoteIcon>();
+    qDBusRegisterMetaType<RemoteIcons>();
     const bool connected = QDBusConnection::sessionBus().registerService(serviceName);
     Q_ASSERT(connected);
     const bool registered = QDBusConnection::sessionBus().registerObject(QStringLiteral("/dave"), this);
     Q_ASSERT(registered);
     m_showLifecycleMethodCalls = showLifecycleMethodCalls;
+    new TestRemoteRunner2(this);
 }
 
 static RemoteImage serializeImage(const QImage &image)
@@ -48,7 +64,26 @@ RemoteMatches TestRemoteRunner::Match(const QString &searchTerm)
 {
     RemoteMatches ms;
     std::cout << "Matching:" << qPrintable(searchTerm) << std::endl;
-    if (searchTerm == QLatin1String("fooCostomIcon")) {
+    if (searchTerm.startsWith(QLatin1String("fooCostomIconRgba64"))) {
+        RemoteMatch m;
+        m.id = QStringLiteral("id2");
+        m.text = QStringLiteral("Match 1");
+        m.relevance = 0.8;
+        QImage icon(10, 10, QImage::Format_RGBA64);
+        icon.fill(QColor(0, 0, 255, 128));
+        RemoteImage remoteImage;
+        remoteImage.width = icon.width();
+        remoteImage.height = icon.height();
+        remoteImage.rowStride = icon.bytesPerLine();
+        remoteImage.hasAlpha = true;
+        remoteImage.bitsPerSample = 16;
+        remoteImage.channels = 4;
+        remoteImage.data = QByteArray(icon.sizeInBytes(), Qt::Uninitialized);
+        // 16 bit samples are sent in little endian byte order
+        qToLittleEndian<quint16>(icon.constBits(), icon.sizeInBytes() / 2, remoteImage.data.data());
+        m.properties[QStringLiteral("icon-data")] = QVariant::fromValue(remoteImage);
+        ms << m;
+    } else if (searchTerm.startsWith(QLatin1String("fooCostomIcon"))) {
         RemoteMatch m;
         m.id = QStringLiteral("id2");
         m.text = QStringLiteral("Match 1");
@@ -59,6 +94,19 @@ RemoteMatches TestRemoteRunner::Match(const QString &searchTerm)
         m.properties[QStringLiteral("icon-data")] = QVariant::fromValue(serializeImage(icon));
 
         ms << m;
+    } else if (searchTerm.startsWith(QLatin1String("fooDeadline"))) {
+        RemoteMatch m;
+        m.id = QStringLiteral("id6");
+        m.text = QStringLiteral("Match 1");
+        m.relevance = 0.8;
+        ms << m;
+        // Services whose name ends with "slow" only reply once the test calls Run with "release",
+        // this way they miss the deadline of wildcard runners
+        if (m_serviceName.endsWith(QLatin1String("slow")) && calledFromDBus()) {
+            setDelayedReply(true);
+            m_delayedReply = message().createReply(QVariant::fromValue(ms));
+            return {};
+        }
     } else if (searchTerm.startsWith(QLatin1String("fooDelay"))) {
         // This special query string "fooDelayNNNN" allows us to introduce a desired delay
         // to simulate a slow query
@@ -102,6 +150,11 @@ void TestRemoteRunner::SetActivationToken(const QString &token)
 
 void TestRemoteRunner::Run(const QString &id, const QString &actionId)
 {
+    if (id == QLatin1String("release") && m_delayedReply.type() == QDBusMessage::ReplyMessage) {
+        QDBusConnection::sessionBus().send(m_delayedReply);
+        m_delayedReply = QDBusMessage();
+        return;
+    }
     std::cout << "Running:" << qPrintable(id) << ":" << qPrintable(actionId) << std::endl;
     std::cout.flush();
 }
@@ -127,6 +180,188 @@ QVariantMap TestRemoteRunner::Config()
     };
 }
 
+TestRemoteRunner2::TestRemoteRunner2(TestRemoteRunner *runner)
+    : QObject(runner)
+    , m_runner(runner)
+    , m_peerServer(new QDBusServer(this))
+{
+    new Krunner2Adaptor(this);
+    const bool registered = QDBusConnection::sessionBus().registerObject(QStringLiteral("/dave2"), this);
+    Q_ASSERT(registered);
+    connect(m_peerServer, &QDBusServer::newConnection, this, [this](QDBusConnection connection) {
+        connection.registerObject(QStringLiteral("/dave2"), this);
+    });
+}
+
+KRunner::Actions TestRemoteRunner2::Actions()
+{
+    return m_runner->Actions();
+}
+
+void TestRemoteRunner2::SetActivationToken(const QString &token)
+{
+    m_runner->SetActivationToken(token);
+}
+
+void TestRemoteRunner2::Run(const QString &id, const QString &actionId)
+{
+    m_runner->Run(id, actionId);
+}
+
+void TestRemoteRunner2::Teardown()
+{
+    m_runner->Teardown();
+}
+
+QVariantMap TestRemoteRunner2::Config()
+{
+    QVariantMap config = m_runner->Config();
+    config.insert(QStringLiteral("CacheKey"), QStringLiteral("1"));
+    if (m_peerServer->isConnected()) {
+        config.insert(QStringLiteral("PeerAddress"), m_peerServer->address());
+    }
+    return config;
+}
+
+void TestRemoteRunner2::StartMatch(const QString &searchTerm, const QString &queryId, const QVariantMap &hints)
+{
+    const bool peer = calledFromDBus() && connection().name() != QDBusConnection::sessionBus().name();
+    std::cout << "StartMatch:" << (peer ? "peer" : "bus") << std::endl;
+    std::cout << "Hints:" << qPrintable(hints.value(QStringLiteral("PreviousQuery")).toString()) << ":"
+              << hints.value(QStringLiteral("SingleRunnerMode")).toBool() << std::endl;
+    RemoteMatches2 matches;
+    if (searchTerm.startsWith(QLatin1String("fooStream"))) {
+        // Reports one match right away and the second one after a delay
+        RemoteMatch2 match;
+        match.id = QStringLiteral("id4");
+        match.text = QStringLiteral("Match 1");
+        match.categoryRelevance = qToUnderlying(KRunner::QueryMatch::CategoryRelevance::Highest);
+        match.relevance = 0.8;
+        Q_EMIT MatchesAvailable(queryId, {match});
+        QTimer::singleShot(500, this, [this, queryId, match]() mutable {
+            if (m_cancelledQueryIds.remove(queryId)) {
+                return;
+            }
+            match.id = QStringLiteral("id5");
+            match.text = QStringLiteral("Match 2");
+            match.relevance = 0.5;
+            Q_EMIT MatchesAvailable(queryId, {match});
+            Q_EMIT MatchFinished(queryId);
+        });
+        return;
+    }
+    if (searchTerm.startsWith(QLatin1String("fooIconUnsealed"))) {
+        // The icon is provided using a file that is truncated right after it was sent
+        RemoteMatch2 match;
+        match.id = QStringLiteral("id6");
+        match.text = QStringLiteral("Match id6");
+        match.iconName = QStringLiteral("fallback-icon");
+        match.relevance = 0.8;
+        match.extras.insert(QStringLiteral("icon-handle"), QStringLiteral("red"));
+        matches << match;
+        Q_EMIT MatchesAvailable(queryId, matches);
+        Q_EMIT MatchFinished(queryId);
+        return;
+    }
+    if (searchTerm.startsWith(QLatin1String("fooIconHandle"))) {
+        // Two matches sharing the same custom icon, which is only transferred once using GetIcons
+        for (const QString &id : {QStringLiteral("id4"), QStringLiteral("id5")}) {
+            RemoteMatch2 match;
+            match.id = id;
+            match.text = QStringLiteral("Match ") + id;
+            match.iconName = QStringLiteral("fallback-icon");
+            match.relevance = 0.8;
+            match.extras.insert(QStringLiteral("icon-handle"), QStringLiteral("blue"));
+            matches << match;
+        }
+        Q_EMIT MatchesAvailable(queryId, matches);
+        Q_EMIT MatchFinished(queryId);
+        return;
+    }
+    const RemoteMatches remoteMatches = m_runner->Match(searchTerm);
+    for (const RemoteMatch &remoteMatch : remoteMatches) {
+        RemoteMatch2 match;
+        match.id = remoteMatch.id;
+        match.text = remoteMatch.text;
+        match.iconName = remoteMatch.iconName;
+        match.categoryRelevance = remoteMatch.categoryRelevance;
+        match.relevance = remoteMatch.relevance;
+        match.category = remoteMatch.properties.value(QStringLiteral("category")).toString();
+        match.subtext = remoteMatch.properties.value(QStringLiteral("subtext")).toString();
+        match.urls = remoteMatch.properties.value(QStringLiteral("urls")).toStringList();
+        match.multiLine = remoteMatch.properties.value(QStringLiteral("multiline")).toBool();
+        if (const auto it = remoteMatch.properties.find(QStringLiteral("actions")); it != remoteMatch.properties.cend()) {
+            match.actions = it->toStringList();
+            match.defaultActions = false;
+        }
+        if (const auto it = remoteMatch.properties.find(QStringLiteral("icon-data")); it != remoteMatch.properties.cend()) {
+            match.extras.insert(it.key(), it.value());
+        }
+        matches << match;
+    }
+    Q_EMIT MatchesAvailable(queryId, matches);
+    Q_EMIT MatchFinished(queryId);
+}
+
+void TestRemoteRunner2::Cancel(const QString &queryId)
+{
+    std::cout << "Cancel" << std::endl;
+    m_cancelledQueryIds.insert(queryId);
+}
+
+RemoteIcons TestRemoteRunner2::GetIcons(const QStringList &handles)
+{
+    std::cout << "GetIcons:" << qPrintable(handles.join(QLatin1Char(','))) << std::endl;
+    RemoteIcons icons;
+    for (const QString &handle : handles) {
+        if (handle != QLatin1String("blue") && handle != QLatin1String("red")) {
+            continue;
+        }
+        QImage image(16, 16, QImage::Format_RGBA8888);
+        image.fill(handle == QLatin1String("blue") ? Qt::blue : Qt::red);
+        const RemoteImage remoteImage = serializeImage(image);
+
+        RemoteIcon icon;
+#if defined(Q_OS_LINUX) && defined(MFD_ALLOW_SEALING)
+        // Well-behaved runners seal their icons, this way KRunner can map them
+        if (handle == QLatin1String("blue")) {
+            const int fd = memfd_create("krunnertest-icon", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+            if (fd != -1) {
+                if (write(fd, remoteImage.data.constData(), remoteImage.data.size()) == remoteImage.data.size()
+                    && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) != -1) {
+                    icon.data = QDBusUnixFileDescriptor(fd); // Duplicates the descriptor
+                }
+                close(fd);
+            }
+        }
+#endif
+        if (!icon.data.isValid()) {
+            auto file = std::make_unique<QTemporaryFile>();
+            if (!file->open() || file->write(remoteImage.data) != remoteImage.data.size() || !file->flush()) {
+                continue;
+            }
+            icon.data = QDBusUnixFileDescriptor(file->handle());
+            if (handle == QLatin1String("red")) {
+                // A broken runner, mapping this file would crash once it is truncated
+                QTimer::singleShot(0, file.get(), [file = file.get()]() {
+                    file->resize(0);
+                });
+            }
+            m_iconFiles.push_back(std::move(file));
+        }
+
+        icon.handle = handle;
+        icon.width = remoteImage.width;
+        icon.height = remoteImage.height;
+        icon.rowStride = remoteImage.rowStride;
+        icon.hasAlpha = remoteImage.hasAlpha;
+        icon.bitsPerSample = remoteImage.bitsPerSample;
+        icon.channels = remoteImage.channels;
+        icons << icon;
+    }
+    return icons;
+}
+
 int main(int argc, char **argv)
 {
     QCoreApplication app(argc, argv);
@@ -7,10 +7,17 @@
 #pragma once
 
 #include "../src/dbusutils_p.h"
+#include <QDBusContext>
+#include <QDBusMessage>
 #include <QObject>
+#include <QSet>
+#include <QTemporaryFile>
 #include <QVariantMap>
 
-class TestRemoteRunner : public QObject
+#include <memory>
+#include <vector>
+
+class TestRemoteRunner : public QObject, protected QDBusContext
 {
     Q_OBJECT
 public:
@@ -26,4 +33,37 @@ public Q_SLOTS:
 
 private:
     bool m_showLifecycleMethodCalls = false;
+    const QString m_serviceName;
+    QDBusMessage m_delayedReply;
+};
+
+class QDBusServer;
+
+// Provides the org.kde.krunner2 interface on /dave2 using the matches of TestRemoteRunner,
+// it is also offered using a peer-to-peer connection
+class TestRemoteRunner2 : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+public:
+    explicit TestRemoteRunner2(TestRemoteRunner *runner);
+
+public Q_SLOTS:
+    KRunner::Actions Actions();
+    void SetActivationToken(const QString &token);
+    void Run(const QString &id, const QString &actionId);
+    void Teardown();
+    QVariantMap Config();
+    void StartMatch(const QString &searchTerm, const QString &queryId, const QVariantMap &hints);
+    void Cancel(const QString &queryId);
+    RemoteIcons GetIcons(const QStringList &handles);
+
+Q_SIGNALS:
+    void MatchesAvailable(const QString &queryId, const RemoteMatches2 &matches);
+    void MatchFinished(const QString &queryId);
+
+private:
+    TestRemoteRunner *const m_runner;
+    QDBusServer *const m_peerServer;
+    std::vector<std::unique_ptr<QTemporaryFile>> m_iconFiles;
+    QSet<QString> m_cancelledQueryIds;
 };
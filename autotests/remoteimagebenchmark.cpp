@@ -0,0 +1,104 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QImage>
+#include <QTest>
+#include <QtEndian>
+
+#include "remoteimage_p.h"
+
+using namespace KRunner;
+
+static RemoteImage remoteImage(const QImage &image, int channels, int bitsPerSample)
+{
+    RemoteImage remoteImage;
+    remoteImage.width = image.width();
+    remoteImage.height = image.height();
+    remoteImage.rowStride = image.bytesPerLine();
+    remoteImage.hasAlpha = image.hasAlphaChannel();
+    remoteImage.bitsPerSample = bitsPerSample;
+    remoteImage.channels = channels;
+    remoteImage.data = QByteArray(reinterpret_cast<const char *>(image.constBits()), image.sizeInBytes());
+    if (bitsPerSample == 16) {
+        qToLittleEndian<quint16>(image.constBits(), image.sizeInBytes() / 2, remoteImage.data.data());
+    }
+    return remoteImage;
+}
+
+// The conversion DBusRunner used before it let QImage convert the pixels, one pixel at a time
+static QImage decodeScalar(const RemoteImage &remoteImage)
+{
+    QImage image(remoteImage.width, remoteImage.height, remoteImage.channels == 4 ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    const char *ptr = remoteImage.data.constData();
+    for (int y = 0; y < remoteImage.height; ++y, ptr += remoteImage.rowStride) {
+        auto dst = reinterpret_cast<QRgb *>(image.scanLine(y));
+        const char *src = ptr;
+        const char *end = src + remoteImage.width * remoteImage.channels;
+        for (; src != end; ++dst, src += remoteImage.channels) {
+            *dst = remoteImage.channels == 4 ? qRgba(src[0], src[1], src[2], src[3]) : qRgb(src[0], src[1], src[2]);
+        }
+    }
+    return image;
+}
+
+class RemoteImageBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    static void addImageRows()
+    {
+        QTest::addColumn<RemoteImage>("image");
+
+        // Thumbnail previews are limited to less than 2048x2048 pixels
+        QImage image(1024, 1024, QImage::Format_RGBA8888);
+        image.fill(QColor(0, 128, 255, 128));
+        QTest::newRow("RGBA8888") << remoteImage(image, 4, 8);
+        QTest::newRow("RGB888") << remoteImage(image.convertToFormat(QImage::Format_RGB888), 3, 8);
+    }
+
+private Q_SLOTS:
+    void benchmarkScalar_data()
+    {
+        addImageRows();
+    }
+
+    void benchmarkScalar()
+    {
+        QFETCH(RemoteImage, image);
+        QBENCHMARK {
+            decodeScalar(image);
+        }
+    }
+
+    void benchmarkDecode_data()
+    {
+        addImageRows();
+        QImage image(1024, 1024, QImage::Format_RGBA64);
+        image.fill(QColor(0, 128, 255, 128));
+        QTest::newRow("RGBA64") << remoteImage(image, 4, 16);
+    }
+
+    void benchmarkDecode()
+    {
+        QFETCH(RemoteImage, image);
+        QBENCHMARK {
+            decodeRemoteImage(image);
+        }
+    }
+
+    void testSixteenBitByteOrder()
+    {
+        QImage image(4, 4, QImage::Format_RGBA64);
+        image.fill(QColor::fromRgba64(0x1234, 0x5678, 0x9abc, 0xffff));
+        const QImage decoded = decodeRemoteImage(remoteImage(image, 4, 16));
+        QCOMPARE(decoded.size(), image.size());
+        QCOMPARE(decoded.pixel(0, 0), qRgba(0x12, 0x56, 0x9a, 0xff));
+    }
+};
+
+QTEST_MAIN(RemoteImageBenchmark)
+
+#include "remoteimagebenchmark.moc"
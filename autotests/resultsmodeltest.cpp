@@ -0,0 +1,111 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <KRunner/ResultsModel>
+#include <KRunner/RunnerManager>
+
+using namespace KRunner;
+
+class ResultsModelTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static void loadFakeRunner(ResultsModel &model)
+    {
+        model.runnerManager()->loadRunner(KPluginMetaData::findPluginById(QStringLiteral("krunnertest"), QStringLiteral("fakerunnerplugin")));
+    }
+
+    static QStringList texts(const ResultsModel &model)
+    {
+        QStringList texts;
+        for (int row = 0; row < model.rowCount(); ++row) {
+            texts << model.index(row, 0).data(Qt::DisplayRole).toString();
+        }
+        return texts;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    void testMatchOrder()
+    {
+        ResultsModel model;
+        loadFakeRunner(model);
+        model.setQueryString(QStringLiteral("tie"));
+
+        // Ordered by relevance, matches with the same relevance by their text
+        QTRY_COMPARE(model.rowCount(), 3);
+        QCOMPARE(texts(model), (QStringList{QStringLiteral("gamma"), QStringLiteral("beta"), QStringLiteral("alpha")}));
+    }
+
+    void testDuplicateIds()
+    {
+        ResultsModel model;
+        loadFakeRunner(model);
+        model.setQueryString(QStringLiteral("duplicates"));
+        QTRY_COMPARE(model.rowCount(), 2);
+        QCOMPARE(texts(model), (QStringList{QStringLiteral("first"), QStringLiteral("second")}));
+        const QPersistentModelIndex secondIndex = model.index(1, 0);
+
+        // Matches sharing an id are paired in order, so their rows are updated instead of being replaced
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        model.setQueryString(QStringLiteral("duplicates again"));
+        QTRY_COMPARE(secondIndex.data(ResultsModel::SubtextRole).toString(), QStringLiteral("duplicates again"));
+        QCOMPARE(secondIndex.row(), 1);
+        QCOMPARE(secondIndex.data(Qt::DisplayRole).toString(), QStringLiteral("second"));
+        QCOMPARE(removedSpy.count(), 0);
+        QCOMPARE(insertedSpy.count(), 0);
+    }
+
+    void testFlatModel_data()
+    {
+        QTest::addColumn<int>("limit");
+        QTest::newRow("unlimited") << 0;
+        QTest::newRow("limited") << 5;
+    }
+
+    void testFlatModel()
+    {
+        QFETCH(int, limit);
+        ResultsModel proxyModel;
+        qputenv("KRUNNER_FLAT_RESULTS_MODEL", "1");
+        ResultsModel flatModel;
+        qunsetenv("KRUNNER_FLAT_RESULTS_MODEL");
+
+        for (ResultsModel *model : {&proxyModel, &flatModel}) {
+            loadFakeRunner(*model);
+            model->setLimit(limit);
+            model->setQueryString(QStringLiteral("categories"));
+        }
+        QTRY_COMPARE(proxyModel.rowCount(), limit ? limit : 12);
+        QTRY_COMPARE(flatModel.rowCount(), proxyModel.rowCount());
+
+        // The flat model shows the same matches in the same order as the proxy chain
+        const QList<int> roles{Qt::DisplayRole,
+                               ResultsModel::IdRole,
+                               ResultsModel::CategoryRole,
+                               ResultsModel::CategoryRelevanceRole,
+                               ResultsModel::RelevanceRole,
+                               ResultsModel::SubtextRole};
+        for (int row = 0; row < proxyModel.rowCount(); ++row) {
+            for (int role : roles) {
+                QCOMPARE(flatModel.index(row, 0).data(role), proxyModel.index(row, 0).data(role));
+            }
+        }
+    }
+};
+
+QTEST_MAIN(ResultsModelTest)
+
+#include "resultsmodeltest.moc"
@@ -6,8 +6,12 @@
 
 #include "abstractrunner.h"
 #include "plugins/fakerunner.h"
+#include "querymatchbatch.h"
+#include "querymatchbuilder.h"
 #include "runnermanager.h"
 
+#include <KConfigGroup>
+#include <KSharedConfig>
 #include <QObject>
 #include <QStandardPaths>
 #include <QTest>
@@ -33,6 +37,9 @@ public:
     std::unique_ptr<RunnerContext> ctx;
     FakeRunner *runner1 = nullptr;
     FakeRunner *runner2 = nullptr;
+    FakeRunner *runner3 = nullptr;
+    FakeRunner *runner4 = nullptr;
+    FakeRunner *runner5 = nullptr;
 private Q_SLOTS:
     void init()
     {
@@ -41,6 +48,14 @@ private Q_SLOTS:
     void testAdd();
     void testAddMulti();
     void testDuplicateIds();
+    void testDuplicateUrls();
+    void testMatchOrder();
+    void testMaxResults();
+    void testMaxResultsConfig();
+    void testBuilder();
+    void testInternedCategories();
+    void testMoveMatches();
+    void testBatch();
 };
 
 RunnerContextMatchMethodsTest::RunnerContextMatchMethodsTest()
@@ -51,10 +66,19 @@ RunnerContextMatchMethodsTest::RunnerContextMatchMethodsTest()
     qputenv("XDG_DATA_DIRS", modifiedDataDirs);
     KPluginMetaData data1 = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/metadatafile1.desktop"));
     KPluginMetaData data2 = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/metadatafile2.desktop"));
+    KPluginMetaData data3 = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/metadatafile3.desktop"));
+    KPluginMetaData data4 = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/metadatafile4.desktop"));
+    KPluginMetaData data5 = parseMetaDataFromDesktopFile(QFINDTESTDATA("plugins/metadatafile5.desktop"));
     QVERIFY(data1.isValid());
     QVERIFY(data2.isValid());
+    QVERIFY(data3.isValid());
+    QVERIFY(data4.isValid());
+    QVERIFY(data5.isValid());
     runner1 = new FakeRunner(this, data1);
     runner2 = new FakeRunner(this, data2);
+    runner3 = new FakeRunner(this, data3);
+    runner4 = new FakeRunner(this, data4);
+    runner5 = new FakeRunner(this, data5);
 }
 
 void RunnerContextMatchMethodsTest::testAdd()
@@ -96,6 +120,244 @@ void RunnerContextMatchMethodsTest::testDuplicateIds()
     QCOMPARE(matches.at(2), match4);
 }
 
+void RunnerContextMatchMethodsTest::testDuplicateUrls()
+{
+    const QUrl url = QUrl::fromLocalFile(QStringLiteral("/tmp/file.txt"));
+    QueryMatch lowPriorityMatch = createMatch(QStringLiteral("id1"), runner4);
+    lowPriorityMatch.setUrls({url});
+    QVERIFY(ctx->addMatch(lowPriorityMatch));
+    QueryMatch otherUrlMatch = createMatch(QStringLiteral("id2"), runner4);
+    otherUrlMatch.setUrls({QUrl::fromLocalFile(QStringLiteral("/tmp/other.txt"))});
+    QVERIFY(ctx->addMatch(otherUrlMatch));
+    // The url is normalized before comparing it
+    QueryMatch highPriorityMatch = createMatch(QStringLiteral("id3"), runner3);
+    highPriorityMatch.setUrls({QUrl::fromLocalFile(QStringLiteral("/tmp/./file.txt"))});
+    QVERIFY(ctx->addMatch(highPriorityMatch));
+    QueryMatch duplicateMatch = createMatch(QStringLiteral("id4"), runner4);
+    duplicateMatch.setUrls({url});
+    QVERIFY(ctx->addMatch(duplicateMatch));
+
+    const QList<QueryMatch> matches = ctx->matches();
+    QCOMPARE(matches.size(), 2);
+    // highPriorityMatch should have replaced lowPriorityMatch, duplicateMatch should have been dropped
+    QCOMPARE(matches.at(0), otherUrlMatch);
+    QCOMPARE(matches.at(1), highPriorityMatch);
+
+    // The id of the replaced match is free again, it must not be treated as a duplicate
+    QueryMatch reusedIdMatch = createMatch(QStringLiteral("id1"), runner4);
+    reusedIdMatch.setUrls({QUrl::fromLocalFile(QStringLiteral("/tmp/new.txt"))});
+    QVERIFY(ctx->addMatch(reusedIdMatch));
+    QCOMPARE(ctx->matches().size(), 3);
+    QVERIFY(ctx->matches().contains(reusedIdMatch));
+
+    // A weak match is kept if the match with the same id that would replace it is dropped because of its url
+    const QueryMatch weakMatch = createMatch(QStringLiteral("id5"), runner1);
+    QVERIFY(ctx->addMatch(weakMatch));
+    QueryMatch droppedMatch = createMatch(QStringLiteral("id5"), runner4);
+    droppedMatch.setUrls({url});
+    QVERIFY(ctx->addMatch(droppedMatch));
+    QCOMPARE(ctx->matches().size(), 4);
+    QVERIFY(ctx->matches().contains(weakMatch));
+    QVERIFY(!ctx->matches().contains(droppedMatch));
+
+    // All matches of a runner pointing to the same url are replaced by the one with a higher priority
+    const QUrl sharedUrl = QUrl::fromLocalFile(QStringLiteral("/tmp/shared.txt"));
+    QueryMatch firstSharedMatch = createMatch(QStringLiteral("id6"), runner4);
+    firstSharedMatch.setUrls({sharedUrl});
+    QueryMatch secondSharedMatch = createMatch(QStringLiteral("id7"), runner4);
+    secondSharedMatch.setUrls({sharedUrl});
+    QVERIFY(ctx->addMatches({firstSharedMatch, secondSharedMatch}));
+    QCOMPARE(ctx->matches().size(), 6);
+    QueryMatch sharedHighPriorityMatch = createMatch(QStringLiteral("id8"), runner3);
+    sharedHighPriorityMatch.setUrls({sharedUrl});
+    QVERIFY(ctx->addMatch(sharedHighPriorityMatch));
+    QCOMPARE(ctx->matches().size(), 5);
+    QVERIFY(!ctx->matches().contains(firstSharedMatch));
+    QVERIFY(!ctx->matches().contains(secondSharedMatch));
+}
+
+void RunnerContextMatchMethodsTest::testMatchOrder()
+{
+    QueryMatch lowRelevanceMatch = createMatch(QStringLiteral("m1"));
+    lowRelevanceMatch.setRelevance(0.1);
+    QueryMatch highRelevanceMatch = createMatch(QStringLiteral("m2"));
+    highRelevanceMatch.setRelevance(0.9);
+    QVERIFY(ctx->addMatches({lowRelevanceMatch, highRelevanceMatch}));
+
+    QueryMatch highCategoryRelevanceMatch = createMatch(QStringLiteral("m3"));
+    highCategoryRelevanceMatch.setCategoryRelevance(QueryMatch::CategoryRelevance::Highest);
+    highCategoryRelevanceMatch.setRelevance(0.1);
+    QueryMatch moderateRelevanceMatch = createMatch(QStringLiteral("m4"));
+    moderateRelevanceMatch.setRelevance(0.5);
+    QVERIFY(ctx->addMatches({moderateRelevanceMatch, highCategoryRelevanceMatch}));
+
+    const QList<QueryMatch> expectedMatches{highCategoryRelevanceMatch, highRelevanceMatch, moderateRelevanceMatch, lowRelevanceMatch};
+    QCOMPARE(ctx->matches(), expectedMatches);
+}
+
+void RunnerContextMatchMethodsTest::testMaxResults()
+{
+    const auto createRelevantMatch = [this](const QString &id, qreal relevance) {
+        QueryMatch match = createMatch(id, runner5);
+        match.setRelevance(relevance);
+        return match;
+    };
+    const QueryMatch match1 = createRelevantMatch(QStringLiteral("m1"), 0.1);
+    const QueryMatch match2 = createRelevantMatch(QStringLiteral("m2"), 0.9);
+    const QueryMatch match3 = createRelevantMatch(QStringLiteral("m3"), 0.5);
+    QVERIFY(ctx->addMatches({match1, match2, match3}));
+    QCOMPARE(ctx->matches(), QList<QueryMatch>({match2, match3}));
+
+    // A more relevant match replaces the least relevant one
+    const QueryMatch match4 = createRelevantMatch(QStringLiteral("m4"), 0.7);
+    QVERIFY(ctx->addMatch(match4));
+    QCOMPARE(ctx->matches(), QList<QueryMatch>({match2, match4}));
+
+    // Matches of other runners are not affected
+    QVERIFY(ctx->addMatches({createMatch(QStringLiteral("m5"), runner1), createMatch(QStringLiteral("m6"), runner2)}));
+    QCOMPARE(ctx->matches().size(), 4);
+}
+
+void RunnerContextMatchMethodsTest::testMaxResultsConfig()
+{
+    // The config entry overrides the metadata once the runner reloads its configuration
+    KConfigGroup config = KSharedConfig::openConfig(QStringLiteral("krunnerrc"))->group(QStringLiteral("Runners")).group(runner5->id());
+    config.writeEntry("MaxResults", 1);
+    QMetaObject::invokeMethod(runner5, "reloadConfigurationInternal");
+    QVERIFY(ctx->addMatches({createMatch(QStringLiteral("m1"), runner5), createMatch(QStringLiteral("m2"), runner5)}));
+    QCOMPARE(ctx->matches().size(), 1);
+
+    config.deleteEntry("MaxResults");
+    QMetaObject::invokeMethod(runner5, "reloadConfigurationInternal");
+    QVERIFY(ctx->addMatch(createMatch(QStringLiteral("m3"), runner5)));
+    QCOMPARE(ctx->matches().size(), 2);
+}
+
+void RunnerContextMatchMethodsTest::testBuilder()
+{
+    QueryMatchBuilder builder(runner1);
+    builder.setId(QStringLiteral("id1")).setText(QStringLiteral("text")).setSubtext(QStringLiteral("subtext")).setRelevance(0.4);
+    builder.setCategoryRelevance(QueryMatch::CategoryRelevance::High).setUrls({QUrl(QStringLiteral("file:///tmp/a"))});
+    const QueryMatch match = builder.build();
+    QCOMPARE(match.runner(), runner1);
+    QCOMPARE(match.id(), createMatch(QStringLiteral("id1"), runner1).id());
+    QCOMPARE(match.text(), QStringLiteral("text"));
+    QCOMPARE(match.subtext(), QStringLiteral("subtext"));
+    QCOMPARE(match.relevance(), 0.4);
+    QCOMPARE(match.categoryRelevance(), qreal(QueryMatch::CategoryRelevance::High));
+    QCOMPARE(match.urls(), QList<QUrl>({QUrl(QStringLiteral("file:///tmp/a"))}));
+
+    // Reusing the builder must not modify matches that were already built
+    const QueryMatch otherMatch = builder.setId(QStringLiteral("id2")).setText(QStringLiteral("other")).build();
+    QCOMPARE(match.text(), QStringLiteral("text"));
+    QCOMPARE(otherMatch.text(), QStringLiteral("other"));
+    QCOMPARE(otherMatch.subtext(), QStringLiteral("subtext"));
+
+    // The setters still work on built matches
+    QueryMatch modifiedMatch = match;
+    modifiedMatch.setText(QStringLiteral("modified"));
+    QCOMPARE(modifiedMatch.text(), QStringLiteral("modified"));
+    QCOMPARE(match.text(), QStringLiteral("text"));
+
+    QVERIFY(ctx->addMatches({match, otherMatch}));
+    QCOMPARE(ctx->matches().size(), 2);
+}
+
+void RunnerContextMatchMethodsTest::testInternedCategories()
+{
+    QueryMatch match1 = createMatch(QStringLiteral("m1"));
+    match1.setMatchCategory(QStringLiteral("category").append(QLatin1Char('1')));
+    const QueryMatch match2 = QueryMatchBuilder().setId(QStringLiteral("m2")).setMatchCategory(QStringLiteral("category1")).build();
+    QCOMPARE(match1.matchCategory(), QStringLiteral("category1"));
+    QCOMPARE(match1.matchCategory().constData(), match2.matchCategory().constData());
+
+    // Matches without an explicit category fall back to the runner name
+    QCOMPARE(createMatch(QStringLiteral("m3"), runner1).matchCategory(), runner1->name());
+}
+
+void RunnerContextMatchMethodsTest::testMoveMatches()
+{
+    QueryMatch match1 = createMatch(QStringLiteral("m1"), runner1);
+    QString text = QStringLiteral("text");
+    match1.setText(std::move(text));
+    QCOMPARE(match1.text(), QStringLiteral("text"));
+
+    QueryMatch movedMatch(std::move(match1));
+    QCOMPARE(movedMatch.text(), QStringLiteral("text"));
+    match1 = createMatch(QStringLiteral("m2"), runner1);
+
+    QList<QueryMatch> matches{movedMatch, match1};
+    QVERIFY(ctx->addMatches(std::move(matches)));
+    QCOMPARE(ctx->matches(), QList<QueryMatch>({movedMatch, match1}));
+
+    const QueryMatch match3 = createMatch(QStringLiteral("m3"), runner1);
+    QVERIFY(ctx->addMatch(QueryMatch(match3)));
+    QCOMPARE(ctx->matches().size(), 3);
+    QVERIFY(ctx->matches().contains(match3));
+}
+
+void RunnerContextMatchMethodsTest::testBatch()
+{
+    QueryMatchBatch batch(runner1);
+    batch.setMatchCategory(QStringLiteral("category"));
+    batch.setCategoryRelevance(QueryMatch::CategoryRelevance::High);
+    batch.addMatch(QStringLiteral("m1"), QStringLiteral("text1"), QStringLiteral("subtext1"), QStringLiteral("icon1"), 0.2, {QUrl(QStringLiteral("file:///a"))});
+    batch.addMatch(QStringLiteral("m2"), QStringLiteral("text2"), QString(), QString(), 0.8);
+    QCOMPARE(batch.size(), 2);
+
+    const QueryMatch match = batch.match(0);
+    QCOMPARE(match.runner(), runner1);
+    QCOMPARE(match.id(), createMatch(QStringLiteral("m1"), runner1).id());
+    QCOMPARE(match.text(), QStringLiteral("text1"));
+    QCOMPARE(match.subtext(), QStringLiteral("subtext1"));
+    QCOMPARE(match.iconName(), QStringLiteral("icon1"));
+    QCOMPARE(match.relevance(), 0.2);
+    QCOMPARE(match.urls(), QList<QUrl>({QUrl(QStringLiteral("file:///a"))}));
+    QCOMPARE(match.matchCategory(), QStringLiteral("category"));
+    QCOMPARE(match.categoryRelevance(), qreal(QueryMatch::CategoryRelevance::High));
+
+    QVERIFY(ctx->addMatches(batch));
+    const QList<QueryMatch> matches = ctx->matches();
+    QCOMPARE(matches.size(), 2);
+    QCOMPARE(matches.at(0).text(), QStringLiteral("text2"));
+    QCOMPARE(matches.at(1).text(), QStringLiteral("text1"));
+
+    const auto textsOf = [this](const AbstractRunner *runner) {
+        QStringList texts;
+        for (const QueryMatch &match : ctx->matches()) {
+            if (match.runner() == runner) {
+                texts << match.text();
+            }
+        }
+        return texts;
+    };
+
+    // Only the most relevant matches are kept if the runner limits its results
+    QueryMatchBatch limitedBatch(runner5);
+    for (int i = 0; i < 5; ++i) {
+        limitedBatch.addMatch(QString::number(i), QString::number(i), QString(), QString(), i / 10.0);
+    }
+    QVERIFY(ctx->addMatches(limitedBatch));
+    QCOMPARE(textsOf(runner5), QStringList({QStringLiteral("4"), QStringLiteral("3")}));
+
+    // Entries that cannot outrank the kept matches are skipped, more relevant ones replace them
+    QueryMatchBatch nextBatch(runner5);
+    nextBatch.addMatch(QStringLiteral("low"), QStringLiteral("low"), QString(), QString(), 0.1);
+    nextBatch.addMatch(QStringLiteral("high"), QStringLiteral("high"), QString(), QString(), 0.9);
+    QVERIFY(ctx->addMatches(nextBatch));
+    QCOMPARE(textsOf(runner5), QStringList({QStringLiteral("high"), QStringLiteral("4")}));
+
+    // Entries pointing to the url of a match with a higher deduplication priority are dropped
+    QueryMatch superiorMatch = createMatch(QStringLiteral("superior"), runner3);
+    superiorMatch.setUrls({QUrl(QStringLiteral("file:///b"))});
+    QVERIFY(ctx->addMatch(superiorMatch));
+    QueryMatchBatch urlBatch(runner4);
+    urlBatch.addMatch(QStringLiteral("inferior"), QStringLiteral("inferior"), QString(), QString(), 1, {QUrl(QStringLiteral("file:///b"))});
+    urlBatch.addMatch(QStringLiteral("other"), QStringLiteral("other"), QString(), QString(), 1, {QUrl(QStringLiteral("file:///c"))});
+    QVERIFY(ctx->addMatches(urlBatch));
+    QCOMPARE(textsOf(runner4), QStringList{QStringLiteral("other")});
+}
+
 QTEST_MAIN(RunnerContextMatchMethodsTest)
 
 #include "runnermatchmethodstest.moc"
@@ -31,6 +31,7 @@ AbstractRunner::AbstractRunner(QObject *parent, const KPluginMetaData &pluginMet
 
     // Suspend matching while we initialize the runner. Once it is ready, the last query will be run
     QTimer::singleShot(0, this, [this]() {
+        d->reloadMaxResults(config());
         init();
         // In case the runner didn't specify anything explicitly, we resume matching after the initialization
         bool doesNotHaveExplicitSuspend = true;
@@ -181,6 +182,7 @@ void AbstractRunner::reloadConfigurationInternal()
 {
     bool isSuspended = isMatchingSuspended();
     suspendMatching(true);
+    d->reloadMaxResults(config());
     reloadConfiguration();
     suspendMatching(isSuspended);
 }
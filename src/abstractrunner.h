@@ -249,6 +249,9 @@ protected:
      * Provides access to the runner's configuration object.
      * This config is saved in the "krunnerrc" file in the [Runners][<pluginId>] config group
      * Settings should be written in a KDE config module. See https://develop.kde.org/docs/plasma/krunner/#runner-configuration
+     *
+     * The "MaxResults" entry of this group overrides the "X-Plasma-Runner-Max-Results" property from the metadata.
+     * It limits how many matches the runner may contribute to a query, only the most relevant ones are kept.
      */
     KConfigGroup config() const;
 
@@ -310,6 +313,7 @@ private:
     friend class RunnerContextPrivate;
     friend class QueryMatchPrivate;
     friend class DBusRunner; // Because it "overrides" matchInternal
+    friend class LocalSocketRunner; // Same as DBusRunner
 };
 
 } // KRunner namespace
@@ -4,6 +4,7 @@
 */
 #include "abstractrunner.h"
 #include "runnersyntax.h"
+#include <KConfigGroup>
 #include <QReadWriteLock>
 #include <QRegularExpression>
 #include <optional>
@@ -20,6 +21,9 @@ public:
         , minLetterCount(data.value(QStringLiteral("X-Plasma-Runner-Min-Letter-Count"), 0))
         , hasUniqueResults(data.value(QStringLiteral("X-Plasma-Runner-Unique-Results"), false))
         , hasWeakResults(data.value(QStringLiteral("X-Plasma-Runner-Weak-Results"), false))
+        , urlDeduplicationPriority(data.value(QStringLiteral("X-Plasma-Runner-Url-Deduplication-Priority"), -1))
+        , defaultMaxResults(data.value(QStringLiteral("X-Plasma-Runner-Max-Results"), 0))
+        , maxResults(defaultMaxResults)
     {
         if (const QString regexStr = data.value(QStringLiteral("X-Plasma-Runner-Match-Regex")); !regexStr.isEmpty()) {
             matchRegex = QRegularExpression(regexStr);
@@ -27,6 +31,21 @@ public:
         }
     }
 
+    // Called on the runner's thread before it is initialized and when its configuration is reloaded, not when it is constructed.
+    // Otherwise loading the runners would open the config once per runner
+    void reloadMaxResults(const KConfigGroup &config)
+    {
+        const int newMaxResults = config.readEntry("MaxResults", defaultMaxResults);
+        QWriteLocker locker(&lock);
+        maxResults = newMaxResults;
+    }
+
+    int currentMaxResults()
+    {
+        QReadLocker locker(&lock);
+        return maxResults;
+    }
+
     QReadWriteLock lock;
     const KPluginMetaData runnerDescription;
     // We can easily call this a few hundred times for a few queries. Thus just reuse the value and not do a lookup of the translated string every time
@@ -39,5 +58,11 @@ public:
     bool hasMatchRegex = false;
     const bool hasUniqueResults = false;
     const bool hasWeakResults = false;
+    // Negative values mean that the matches of this runner are not deduplicated by their urls
+    const int urlDeduplicationPriority = -1;
+    // The value from the metadata may be overwritten by the user using the MaxResults entry of the runner's config group, 0 means unlimited
+    const int defaultMaxResults = 0;
+    // Guarded by lock, because it is read by the RunnerContext from the threads of other runners
+    int maxResults = 0;
 };
 }
@@ -8,36 +8,74 @@
 
 #include "dbusrunner_p.h"
 
+#include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
 #include <QDBusMessage>
 #include <QDBusMetaType>
 #include <QDBusPendingReply>
+#include <QFile>
+#include <QFuture>
 #include <QGuiApplication>
 #include <QIcon>
+#include <QMutexLocker>
+#include <QPromise>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
 #include <set>
 
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
 #include <KWaylandExtras>
 #include <KWindowSystem>
 
+#include "abstractrunner_p.h"
 #include "dbusutils_p.h"
 #include "krunner_debug.h"
+#include "querymatchbuilder.h"
+#include "remoteimage_p.h"
 
 namespace KRunner
 {
+static int apiVersion(const KPluginMetaData &data)
+{
+    const QString api = data.value(QStringLiteral("X-Plasma-API"));
+    return api == QLatin1String("DBus") ? 1 : QStringView(api).mid(4).toInt();
+}
+
+// All DBus runners share one connection, their traffic does not queue up behind the one of the application
+static QDBusConnection runnerBus()
+{
+    return QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("krunner-dbusrunners"));
+}
+
 DBusRunner::DBusRunner(QObject *parent, const KPluginMetaData &data)
     : KRunner::AbstractRunner(parent, data)
+    , m_bus(runnerBus())
     , m_path(data.value(QStringLiteral("X-Plasma-DBusRunner-Path"), QStringLiteral("/runner")))
     , m_hasUniqueResults(data.value(QStringLiteral("X-Plasma-Runner-Unique-Results"), false))
     , m_requestActionsOnce(data.value(QStringLiteral("X-Plasma-Request-Actions-Once"), false))
-    , m_callLifecycleMethods(data.value(QStringLiteral("X-Plasma-API")) == QLatin1String("DBus2"))
-    , m_ifaceName(QStringLiteral("org.kde.krunner1"))
+    , m_apiVersion(apiVersion(data))
+    , m_matchTimeout(data.value(QStringLiteral("X-Plasma-DBusRunner-Match-Timeout"), -1))
+    , m_serviceDeadline(data.value(QStringLiteral("X-Plasma-DBusRunner-Service-Deadline"), 500))
+    , m_callLifecycleMethods(m_apiVersion >= 2)
+    , m_ifaceName(m_apiVersion >= 3 ? QStringLiteral("org.kde.krunner2") : QStringLiteral("org.kde.krunner1"))
 {
     qDBusRegisterMetaType<RemoteMatch>();
     qDBusRegisterMetaType<RemoteMatches>();
+    qDBusRegisterMetaType<RemoteMatch2>();
+    qDBusRegisterMetaType<RemoteMatches2>();
     qDBusRegisterMetaType<KRunner::Action>();
     qDBusRegisterMetaType<KRunner::Actions>();
     qDBusRegisterMetaType<RemoteImage>();
+    qDBusRegisterMetaType<RemoteIcon>();
+    qDBusRegisterMetaType<RemoteIcons>();
 
     QString requestedServiceName = data.value(QStringLiteral("X-Plasma-DBusRunner-Service"));
     if (requestedServiceName.isEmpty() || m_path.isEmpty()) {
@@ -47,49 +85,49 @@ DBusRunner::DBusRunner(QObject *parent, const KPluginMetaData &data)
 
     if (requestedServiceName.endsWith(QLatin1Char('*'))) {
         requestedServiceName.chop(1);
-        // find existing matching names
-        auto namesReply = QDBusConnection::sessionBus().interface()->registeredServiceNames();
-        if (namesReply.isValid()) {
-            const auto names = namesReply.value();
-            for (const QString &serviceName : names) {
-                if (serviceName.startsWith(requestedServiceName)) {
-                    m_matchingServices << serviceName;
-                }
+        m_isWildcard = true;
+        // The names on the bus are looked up asynchronously and shared by all runners, matching is suspended until they are known
+        DBusNameCache *nameCache = DBusNameCache::instance();
+        connect(nameCache, &DBusNameCache::nameAdded, this, [this, requestedServiceName](const QString &serviceName) {
+            if (serviceName.startsWith(requestedServiceName)) {
+                addMatchingService(serviceName);
             }
+        });
+        connect(nameCache, &DBusNameCache::nameRemoved, this, [this, requestedServiceName](const QString &serviceName) {
+            if (serviceName.startsWith(requestedServiceName)) {
+                removeMatchingService(serviceName);
+            }
+        });
+        m_waitingForServices = true;
+        suspendMatching(true);
+        connect(
+            nameCache,
+            &DBusNameCache::ready,
+            this,
+            [this, requestedServiceName]() {
+                onServicesDiscovered(requestedServiceName);
+            },
+            Qt::SingleShotConnection);
+        if (nameCache->isReady()) {
+            onServicesDiscovered(requestedServiceName);
         }
-        // and watch for changes
-        connect(QDBusConnection::sessionBus().interface(),
-                &QDBusConnectionInterface::serviceOwnerChanged,
-                this,
-                [this, requestedServiceName](const QString &serviceName, const QString &oldOwner, const QString &newOwner) {
-                    if (!serviceName.startsWith(requestedServiceName)) {
-                        return;
-                    }
-                    if (!oldOwner.isEmpty() && !newOwner.isEmpty()) {
-                        // changed owner, but service still exists. Don't need to adjust anything
-                        return;
-                    }
-                    if (!newOwner.isEmpty()) {
-                        m_matchingServices.insert(serviceName);
-                    }
-                    if (!oldOwner.isEmpty()) {
-                        m_matchingServices.remove(serviceName);
-                    }
-                });
     } else {
         // don't check when not wildcarded, as it could be used with DBus-activation
         m_matchingServices << requestedServiceName;
+        connectMatchSignals(requestedServiceName);
     }
 
+    connect(this, &AbstractRunner::prepare, this, &DBusRunner::prewarmServices);
     connect(this, &AbstractRunner::teardown, this, [this]() {
         if (m_matchWasCalled) {
             for (const QString &service : std::as_const(m_matchingServices)) {
-                auto method = QDBusMessage::createMethodCall(service, m_path, m_ifaceName, QStringLiteral("Teardown"));
-                QDBusConnection::sessionBus().asyncCall(method);
+                auto method = createMethodCall(service, QStringLiteral("Teardown"));
+                connection(service).asyncCall(method);
             }
         }
         m_actionsForSessionRequested = false;
         m_matchWasCalled = false;
+        m_previousQuery.clear();
     });
 
     // Load the runner syntaxes
@@ -103,15 +141,244 @@ DBusRunner::DBusRunner(QObject *parent, const KPluginMetaData &data)
     }
 }
 
+void DBusRunner::onServicesDiscovered(const QString &servicePrefix)
+{
+    if (!m_waitingForServices) {
+        return;
+    }
+    m_waitingForServices = false;
+    const QStringList serviceNames = DBusNameCache::instance()->names(servicePrefix);
+    for (const QString &serviceName : serviceNames) {
+        addMatchingService(serviceName);
+    }
+    if (m_callLifecycleMethods && !m_matchingServices.isEmpty()) {
+        requestConfig();
+    } else {
+        suspendMatching(false);
+    }
+}
+
+void DBusRunner::addMatchingService(const QString &service)
+{
+    if (!m_matchingServices.contains(service)) {
+        m_matchingServices.insert(service);
+        connectMatchSignals(service);
+    }
+}
+
+void DBusRunner::removeMatchingService(const QString &service)
+{
+    if (m_matchingServices.remove(service)) {
+        disconnectMatchSignals(service);
+        disconnectFromPeer(service);
+        m_remoteIcons.remove(service);
+        m_serviceStats.remove(service);
+    }
+}
+
+DBusRunner::~DBusRunner()
+{
+    for (const QString &connectionName : std::as_const(m_peerConnections)) {
+        QDBusConnection::disconnectFromPeer(connectionName);
+    }
+}
+
+QDBusConnection DBusRunner::connection(const QString &service) const
+{
+    if (const auto it = m_peerConnections.constFind(service); it != m_peerConnections.cend()) {
+        return QDBusConnection(it.value());
+    }
+    return m_bus;
+}
+
+QDBusMessage DBusRunner::createMethodCall(const QString &service, const QString &method) const
+{
+    // Messages on a peer-to-peer connection have no destination
+    return QDBusMessage::createMethodCall(m_peerConnections.contains(service) ? QString() : service, m_path, m_ifaceName, method);
+}
+
+void DBusRunner::connectToPeer(const QString &service, const QString &address)
+{
+    if (m_peerConnections.contains(service) || m_connectingPeers.contains(service) || address.isEmpty()) {
+        return;
+    }
+    // Connection names are global to the process, the same runner may be loaded by several RunnerManagers
+    const QString connectionName = QStringLiteral("krunner-%1-%2-%3").arg(id(), service, QString::number(quintptr(this), 16));
+    m_connectingPeers.insert(service);
+
+    // Connecting blocks until the runner completed the authentication, the session bus is used in the meantime
+    auto promise = std::make_shared<QPromise<bool>>();
+    QFuture<bool> future = promise->future();
+    promise->start();
+    QThreadPool::globalInstance()->start([promise, address, connectionName]() {
+        promise->addResult(QDBusConnection::connectToPeer(address, connectionName).isConnected());
+        promise->finish();
+    });
+    future
+        .then(this,
+              [this, service, address, connectionName](bool connected) {
+                  m_connectingPeers.remove(service);
+                  if (!connected) {
+                      qCWarning(KRUNNER) << "Could not connect to" << service << "using" << address
+                                         << ", falling back to the session bus:" << QDBusConnection(connectionName).lastError().message();
+                      QDBusConnection::disconnectFromPeer(connectionName);
+                      return;
+                  }
+                  if (!m_matchingServices.contains(service)) {
+                      // The service went away while connecting
+                      QDBusConnection::disconnectFromPeer(connectionName);
+                      return;
+                  }
+                  // The signals of the service must not be received twice
+                  disconnectMatchSignals(service);
+                  m_peerConnections.insert(service, connectionName);
+                  connectMatchSignals(service);
+              })
+        .onCanceled([connectionName]() {
+            // The runner was deleted while connecting
+            QDBusConnection::disconnectFromPeer(connectionName);
+        });
+}
+
+void DBusRunner::disconnectFromPeer(const QString &service)
+{
+    if (!m_peerConnections.contains(service)) {
+        return;
+    }
+    disconnectMatchSignals(service);
+    QDBusConnection::disconnectFromPeer(m_peerConnections.take(service));
+    if (m_matchingServices.contains(service)) {
+        connectMatchSignals(service);
+    }
+}
+
+void DBusRunner::handlePeerError(const QString &service, const QDBusError &error)
+{
+    if (error.type() == QDBusError::Disconnected && m_peerConnections.contains(service)) {
+        qCDebug(KRUNNER) << "Peer-to-peer connection to" << service << "was closed, falling back to the session bus";
+        disconnectFromPeer(service);
+    }
+}
+
+void DBusRunner::prewarmServices()
+{
+    // Services of wildcard runners are already running, the others might only get started by the bus on demand
+    if (m_isWildcard) {
+        return;
+    }
+    for (const QString &service : std::as_const(m_matchingServices)) {
+        if (m_peerConnections.contains(service)) {
+            continue;
+        }
+        // Any message activates the service, the reply is of no interest
+        auto pingMethod = QDBusMessage::createMethodCall(service, m_path, QStringLiteral("org.freedesktop.DBus.Peer"), QStringLiteral("Ping"));
+        m_bus.asyncCall(pingMethod);
+    }
+}
+
 void DBusRunner::reloadConfiguration()
 {
     // If we have already loaded a config, but the runner is told to reload it's config
     if (m_callLifecycleMethods) {
-        suspendMatching(true);
         requestConfig();
     }
 }
 
+KConfigGroup DBusRunner::cacheGroup(const QString &service) const
+{
+    auto cache = KSharedConfig::openConfig(QStringLiteral("krunnerdbusrunnercache"), KConfig::SimpleConfig, QStandardPaths::GenericCacheLocation);
+    return cache->group(id()).group(service);
+}
+
+bool DBusRunner::applyCachedConfig(const QString &service)
+{
+    const KConfigGroup group = cacheGroup(service);
+    const QString cacheKey = group.readEntry("CacheKey", QString());
+    if (cacheKey.isEmpty()) {
+        return false;
+    }
+    QVariantMap config;
+    if (group.hasKey("MatchRegex")) {
+        config.insert(QStringLiteral("MatchRegex"), group.readEntry("MatchRegex", QString()));
+    }
+    if (group.hasKey("MinLetterCount")) {
+        config.insert(QStringLiteral("MinLetterCount"), group.readEntry("MinLetterCount", 0));
+    }
+    if (group.hasKey("TriggerWords")) {
+        config.insert(QStringLiteral("TriggerWords"), group.readEntry("TriggerWords", QStringList()));
+    }
+    applyConfig(service, config);
+
+    if (group.hasKey("ActionIds")) {
+        const QStringList ids = group.readEntry("ActionIds", QStringList());
+        const QStringList texts = group.readEntry("ActionTexts", QStringList());
+        const QStringList iconNames = group.readEntry("ActionIconNames", QStringList());
+        KRunner::Actions actions;
+        for (int i = 0, count = std::min({ids.size(), texts.size(), iconNames.size()}); i < count; ++i) {
+            actions << KRunner::Action(ids.at(i), iconNames.at(i), texts.at(i));
+        }
+        m_actions[service] = actions;
+        m_cachedActionServices << service;
+    }
+    m_cacheKeys.insert(service, cacheKey);
+    return true;
+}
+
+void DBusRunner::writeCache(const QString &service, const QVariantMap &config)
+{
+    KConfigGroup group = cacheGroup(service);
+    const QString cacheKey = config.value(QStringLiteral("CacheKey")).toString();
+    if (cacheKey.isEmpty()) {
+        // The runner does not want its config to be cached (anymore)
+        if (group.exists()) {
+            group.deleteGroup();
+            group.sync();
+        }
+        m_cacheKeys.remove(service);
+        m_cachedActionServices.remove(service);
+        return;
+    }
+
+    if (group.readEntry("CacheKey", QString()) != cacheKey) {
+        group.deleteGroup();
+        group.writeEntry("CacheKey", cacheKey);
+    }
+    for (const char *key : {"MatchRegex", "MinLetterCount", "TriggerWords"}) {
+        const QVariant value = config.value(QLatin1String(key));
+        if (value.isValid()) {
+            group.writeEntry(key, value);
+        } else {
+            group.deleteEntry(key);
+        }
+    }
+    group.sync();
+    m_cacheKeys.insert(service, cacheKey);
+    if (const auto it = m_actions.constFind(service); it != m_actions.cend()) {
+        writeCachedActions(service, it.value());
+    }
+}
+
+void DBusRunner::writeCachedActions(const QString &service, const KRunner::Actions &actions)
+{
+    if (!m_cacheKeys.contains(service)) {
+        return;
+    }
+    QStringList ids;
+    QStringList texts;
+    QStringList iconNames;
+    for (const KRunner::Action &action : actions) {
+        ids << action.id();
+        texts << action.text();
+        iconNames << action.iconSource();
+    }
+    KConfigGroup group = cacheGroup(service);
+    group.writeEntry("ActionIds", ids);
+    group.writeEntry("ActionTexts", texts);
+    group.writeEntry("ActionIconNames", iconNames);
+    group.sync();
+    m_cachedActionServices << service;
+}
+
 void DBusRunner::requestActionsForService(const QString &service, const std::function<void()> &finishedCallback)
 {
     if (m_actionsForSessionRequested) {
@@ -127,24 +394,54 @@ void DBusRunner::requestActionsForService(const QString &service, const std::fun
         }
     }
 
-    auto getActionsMethod = QDBusMessage::createMethodCall(service, m_path, m_ifaceName, QStringLiteral("Actions"));
-    QDBusPendingReply<QList<KRunner::Action>> reply = QDBusConnection::sessionBus().asyncCall(getActionsMethod);
-    connect(new QDBusPendingCallWatcher(reply), &QDBusPendingCallWatcher::finished, this, [this, service, reply, finishedCallback](auto watcher) {
+    // Cached actions are used right away, they get refreshed in the background
+    const bool cached = m_cachedActionServices.contains(service);
+    if (cached) {
+        finishedCallback();
+    }
+
+    auto getActionsMethod = createMethodCall(service, QStringLiteral("Actions"));
+    QDBusPendingReply<QList<KRunner::Action>> reply = connection(service).asyncCall(getActionsMethod);
+    connect(new QDBusPendingCallWatcher(reply), &QDBusPendingCallWatcher::finished, this, [this, service, reply, finishedCallback, cached](auto watcher) {
         watcher->deleteLater();
         if (!reply.isValid()) {
             qCDebug(KRUNNER) << "Error requesting actions; calling" << service << " :" << reply.error().name() << reply.error().message();
         } else {
-            m_actions[service] = reply.value();
+            const KRunner::Actions actions = reply.value();
+            // Action::operator== only compares the ids
+            const KRunner::Actions previousActions = m_actions.value(service);
+            const bool changed = !std::equal(actions.cbegin(), actions.cend(), previousActions.cbegin(), previousActions.cend(), [](const auto &a, const auto &b) {
+                return a.id() == b.id() && a.text() == b.text() && a.iconSource() == b.iconSource();
+            });
+            if (!cached || changed) {
+                writeCachedActions(service, actions);
+            }
+            m_actions[service] = actions;
+        }
+        if (!cached) {
+            finishedCallback();
         }
-        finishedCallback();
     });
 }
 
 void DBusRunner::requestConfig()
 {
+    if (m_waitingForServices) {
+        return; // Requested once the services are known
+    }
+    if (m_matchingServices.isEmpty()) {
+        suspendMatching(false);
+        return;
+    }
     const QString service = *m_matchingServices.constBegin();
+    // With a cached config the first query can be run right away, the config gets refreshed in the background
+    if (applyCachedConfig(service)) {
+        suspendMatching(false);
+    } else {
+        suspendMatching(true);
+    }
     auto getConfigMethod = QDBusMessage::createMethodCall(service, m_path, m_ifaceName, QStringLiteral("Config"));
-    QDBusPendingReply<QVariantMap> reply = QDBusConnection::sessionBus().asyncCall(getConfigMethod);
+    QDBusPendingReply<QVariantMap> reply = m_bus.asyncCall(getConfigMethod);
 
     auto watcher = new QDBusPendingCallWatcher(reply);
     connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, service]() {
@@ -156,28 +453,115 @@ void DBusRunner::requestConfig()
             return;
         }
         const QVariantMap config = reply.value();
-        for (auto it = config.cbegin(), end = config.cend(); it != end; ++it) {
-            if (it.key() == QLatin1String("MatchRegex")) {
-                QRegularExpression regex(it.value().toString());
-                setMatchRegex(regex);
-            } else if (it.key() == QLatin1String("MinLetterCount")) {
-                setMinLetterCount(it.value().toInt());
-            } else if (it.key() == QLatin1String("TriggerWords")) {
-                setTriggerWords(it.value().toStringList());
-            } else if (it.key() == QLatin1String("Actions")) {
-                m_actions[service] = it.value().value<QList<KRunner::Action>>();
-                m_requestedActionServices << service;
+        applyConfig(service, config);
+        writeCache(service, config);
+        suspendMatching(false);
+    });
+}
+
+void DBusRunner::applyConfig(const QString &service, const QVariantMap &config)
+{
+    for (auto it = config.cbegin(), end = config.cend(); it != end; ++it) {
+        if (it.key() == QLatin1String("MatchRegex")) {
+            QRegularExpression regex(it.value().toString());
+            setMatchRegex(regex);
+        } else if (it.key() == QLatin1String("MinLetterCount")) {
+            setMinLetterCount(it.value().toInt());
+        } else if (it.key() == QLatin1String("TriggerWords")) {
+            setTriggerWords(it.value().toStringList());
+        } else if (it.key() == QLatin1String("Actions")) {
+            m_actions[service] = it.value().value<QList<KRunner::Action>>();
+            m_requestedActionServices << service;
+        } else if (it.key() == QLatin1String("PeerAddress")) {
+            connectToPeer(service, it.value().toString());
+        }
+    }
+}
+
+DBusNameCache::DBusNameCache(const QDBusConnection &bus)
+{
+    connect(bus.interface(), &QDBusConnectionInterface::serviceOwnerChanged, this, &DBusNameCache::onServiceOwnerChanged);
+
+    QDBusPendingReply<QStringList> reply = bus.interface()->asyncCall(QStringLiteral("ListNames"));
+    auto watcher = new QDBusPendingCallWatcher(reply, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        QDBusPendingReply<QStringList> reply = *watcher;
+        if (reply.isError()) {
+            qCWarning(KRUNNER) << "Error listing the names on the bus:" << reply.error().name() << reply.error().message();
+        }
+        {
+            QMutexLocker locker(&m_mutex);
+            const QStringList names = reply.isValid() ? reply.value() : QStringList();
+            for (const QString &name : names) {
+                m_names.insert(name);
             }
+            m_ready = true;
         }
-        suspendMatching(false);
+        Q_EMIT ready();
     });
 }
 
+DBusNameCache *DBusNameCache::instance()
+{
+    // Lives on the main thread, the runners get notified through queued connections.
+    // It watches the connection of the application, which is the one services are usually waited for on. On the connection
+    // of the runners NameOwnerChanged could be processed later, and a service that was just registered would be missed
+    static DBusNameCache *const cache = []() {
+        auto cache = new DBusNameCache(QDBusConnection::sessionBus());
+        cache->moveToThread(QCoreApplication::instance()->thread());
+        cache->setParent(QCoreApplication::instance());
+        return cache;
+    }();
+    return cache;
+}
+
+bool DBusNameCache::isReady() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ready;
+}
+
+QStringList DBusNameCache::names(const QString &prefix) const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList names;
+    for (const QString &name : m_names) {
+        if (name.startsWith(prefix)) {
+            names << name;
+        }
+    }
+    return names;
+}
+
+void DBusNameCache::onServiceOwnerChanged(const QString &serviceName, const QString &oldOwner, const QString &newOwner)
+{
+    if (!oldOwner.isEmpty() && !newOwner.isEmpty()) {
+        // changed owner, but service still exists. Don't need to adjust anything
+        return;
+    }
+    if (!newOwner.isEmpty()) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_names.insert(serviceName);
+        }
+        Q_EMIT nameAdded(serviceName);
+    }
+    if (!oldOwner.isEmpty()) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_names.remove(serviceName);
+        }
+        Q_EMIT nameRemoved(serviceName);
+    }
+}
+
 QList<QueryMatch> DBusRunner::convertMatches(const QString &service, const RemoteMatches &remoteMatches)
 {
     QList<KRunner::QueryMatch> matches;
+    matches.reserve(remoteMatches.size());
     for (const RemoteMatch &match : remoteMatches) {
-        KRunner::QueryMatch m(this);
+        KRunner::QueryMatchBuilder m(this);
 
         m.setText(match.text);
         m.setIconName(match.iconName);
@@ -193,78 +577,474 @@ QList<QueryMatch> DBusRunner::convertMatches(const QString &service, const Remot
         m.setMultiLine(match.properties.value(QStringLiteral("multiline")).toBool());
 
         const auto actionsIt = match.properties.find(QStringLiteral("actions"));
-        const KRunner::Actions actionList = m_actions.value(service);
         if (actionsIt == match.properties.cend()) {
-            m.setActions(actionList);
+            m.setActions(m_actions.value(service));
         } else {
-            KRunner::Actions requestedActions;
-            const QStringList actionIds = actionsIt.value().toStringList();
-            for (const auto &action : actionList) {
-                if (actionIds.contains(action.id())) {
-                    requestedActions << action;
-                }
-            }
-            m.setActions(requestedActions);
+            m.setActions(requestedActions(service, actionsIt.value().toStringList()));
         }
 
-        const QVariant iconData = match.properties.value(QStringLiteral("icon-data"));
-        if (iconData.isValid()) {
-            const auto iconDataArgument = iconData.value<QDBusArgument>();
-            if (iconDataArgument.currentType() == QDBusArgument::StructureType && iconDataArgument.currentSignature() == QLatin1String("(iiibiiay)")) {
-                const auto remoteImage = qdbus_cast<RemoteImage>(iconDataArgument);
-                if (QImage decodedImage = decodeImage(remoteImage); !decodedImage.isNull()) {
-                    const QPixmap pix = QPixmap::fromImage(std::move(decodedImage));
-                    QIcon icon(pix);
-                    m.setIcon(icon);
-                    // iconName normally takes precedence
+        setIconData(m, match.properties.value(QStringLiteral("icon-data")));
+        matches.append(m.build());
+    }
+    return matches;
+}
+
+QList<QueryMatch> DBusRunner::convertMatches(const QString &service, const RemoteMatches2 &remoteMatches)
+{
+    QList<KRunner::QueryMatch> matches;
+    matches.reserve(remoteMatches.size());
+    const QVariantList data({service});
+    for (const RemoteMatch2 &match : remoteMatches) {
+        KRunner::QueryMatchBuilder m(this);
+
+        m.setText(match.text);
+        m.setIconName(match.iconName);
+        m.setCategoryRelevance(match.categoryRelevance);
+        m.setRelevance(match.relevance);
+        m.setUrls(QUrl::fromStringList(match.urls));
+        m.setMatchCategory(match.category);
+        m.setSubtext(match.subtext);
+        m.setData(data);
+        m.setId(match.id);
+        m.setMultiLine(match.multiLine);
+        m.setActions(match.defaultActions ? m_actions.value(service) : requestedActions(service, match.actions));
+
+        if (!match.extras.isEmpty()) {
+            setIconData(m, match.extras.value(QStringLiteral("icon-data")));
+            if (const QString iconHandle = match.extras.value(QStringLiteral("icon-handle")).toString(); !iconHandle.isEmpty()) {
+                const QImage image = m_remoteIcons.value(service).value(iconHandle);
+                if (!image.isNull()) {
+                    const QByteArray key = QByteArrayLiteral("dbus-handle:") + service.toUtf8() + ':' + iconHandle.toUtf8();
+                    m.setIconLoader(key, [image]() {
+                        return QIcon(QPixmap::fromImage(image));
+                    });
                     m.setIconName(QString());
                 }
-            } else {
-                qCWarning(KRUNNER) << "Invalid signature of icon-data property:" << iconDataArgument.currentSignature();
             }
         }
-        matches.append(m);
+        matches.append(m.build());
     }
     return matches;
 }
-void DBusRunner::matchInternal(KRunner::RunnerContext context)
+
+KRunner::Actions DBusRunner::requestedActions(const QString &service, const QStringList &actionIds) const
 {
-    const QString jobId = context.runnerJobId(this);
-    if (m_matchingServices.isEmpty()) {
-        Q_EMIT matchInternalFinished(jobId);
+    KRunner::Actions requestedActions;
+    const KRunner::Actions actionList = m_actions.value(service);
+    for (const auto &action : actionList) {
+        if (actionIds.contains(action.id())) {
+            requestedActions << action;
+        }
+    }
+    return requestedActions;
+}
+
+void DBusRunner::setIconData(QueryMatchBuilder &match, const QVariant &iconData)
+{
+    if (!iconData.isValid()) {
+        return;
     }
+    const auto iconDataArgument = iconData.value<QDBusArgument>();
+    if (iconDataArgument.currentType() == QDBusArgument::StructureType && iconDataArgument.currentSignature() == QLatin1String("(iiibiiay)")) {
+        const auto remoteImage = qdbus_cast<RemoteImage>(iconDataArgument);
+        // Decoding is deferred until the icon is shown, runners often send the same icon for many matches
+        match.setIconLoader(iconCacheKey(remoteImage), [remoteImage]() {
+            QImage decodedImage = decodeRemoteImage(remoteImage);
+            return decodedImage.isNull() ? QIcon() : QIcon(QPixmap::fromImage(std::move(decodedImage)));
+        });
+        // iconName normally takes precedence
+        match.setIconName(QString());
+    } else {
+        qCWarning(KRUNNER) << "Invalid signature of icon-data property:" << iconDataArgument.currentSignature();
+    }
+}
+
+void DBusRunner::matchInternal(KRunner::RunnerContext context)
+{
     m_matchWasCalled = true;
 
     // we scope watchers to make sure the lambda that captures context by reference definitely gets disconnected when this function ends
-    std::shared_ptr<std::set<QString>> pendingServices(new std::set<QString>);
-
+    auto job = std::make_shared<PendingJob>();
+    job->id = context.runnerJobId(this);
+    job->elapsed.start();
     for (const QString &service : std::as_const(m_matchingServices)) {
-        pendingServices->insert(service);
+        if (isQuarantined(service)) {
+            qCDebug(KRUNNER) << "Skipping" << service << "because it repeatedly missed the deadline";
+        } else {
+            job->services.insert(service);
+        }
+    }
+    if (job->services.empty()) {
+        Q_EMIT matchInternalFinished(job->id);
+        return;
+    }
+
+    // One hanging service of a wildcard runner must not hold back the others, its replies are still added when they arrive late
+    if (m_isWildcard && m_serviceDeadline > 0) {
+        QTimer::singleShot(m_serviceDeadline, this, [this, job]() {
+            const std::set<QString> lateServices = job->services;
+            for (const QString &service : lateServices) {
+                qCDebug(KRUNNER) << service << "missed the deadline of" << m_serviceDeadline << "ms";
+                recordMissedDeadline(service);
+                finishService(service, job, false);
+            }
+        });
+    }
 
+    // The hints are the same for all services, the query only becomes the previous one once all of them were asked
+    const QVariantMap hints = m_apiVersion >= 3 ? matchHints(context) : QVariantMap();
+    const std::set<QString> services = job->services;
+    for (const QString &service : services) {
         const auto onActionsFinished = [=, this]() mutable {
-            auto matchMethod = QDBusMessage::createMethodCall(service, m_path, m_ifaceName, QStringLiteral("Match"));
+            if (m_apiVersion >= 3) {
+                startMatch(service, context, hints, job);
+                return;
+            }
+            auto matchMethod = createMethodCall(service, QStringLiteral("Match"));
             matchMethod.setArguments(QList<QVariant>({context.query()}));
-            QDBusPendingReply<RemoteMatches> reply = QDBusConnection::sessionBus().asyncCall(matchMethod);
+            QDBusPendingReply<RemoteMatches> reply = connection(service).asyncCall(matchMethod, m_matchTimeout);
 
             auto watcher = new QDBusPendingCallWatcher(reply);
 
-            connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service, context, reply, jobId, pendingServices, watcher]() mutable {
+            connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service, context, reply, job, watcher]() mutable {
                 watcher->deleteLater();
-                pendingServices->erase(service);
                 if (reply.isError()) {
                     qCWarning(KRUNNER) << "Error requesting matches; calling" << service << " :" << reply.error().name() << reply.error().message();
-                } else {
+                    handlePeerError(service, reply.error());
+                } else if (context.isValid()) {
+                    // Replies for outdated queries are dropped before converting them
                     context.addMatches(convertMatches(service, reply.value()));
                 }
-                // We are finished when all watchers finished
-                if (pendingServices->size() == 0) {
-                    Q_EMIT matchInternalFinished(jobId);
-                }
+                finishService(service, job);
             });
         };
         requestActionsForService(service, onActionsFinished);
     }
     m_actionsForSessionRequested = true;
+    m_previousQuery = context.query();
+}
+
+void DBusRunner::finishService(const QString &service, const std::shared_ptr<PendingJob> &job, bool inTime)
+{
+    if (job->services.erase(service) == 0) {
+        // Late reply of a service that missed the deadline, the job is already finished
+        recordLatency(service, job->elapsed.elapsed(), false);
+        return;
+    }
+    // A service that missed the deadline has not replied yet, its latency is recorded once the late reply arrives
+    if (inTime) {
+        recordLatency(service, job->elapsed.elapsed(), true);
+    }
+    // We are finished when all services finished
+    if (job->services.empty()) {
+        Q_EMIT matchInternalFinished(job->id);
+    }
+}
+
+void DBusRunner::recordLatency(const QString &service, qint64 latency, bool inTime)
+{
+    ServiceStats &stats = m_serviceStats[service];
+    // Moving average, so that a single slow reply does not dominate
+    stats.averageLatency = stats.averageLatency < 0 ? latency : (stats.averageLatency * 3 + latency) / 4;
+    if (inTime) {
+        stats.missedDeadlines = 0;
+    }
+}
+
+void DBusRunner::recordMissedDeadline(const QString &service)
+{
+    ServiceStats &stats = m_serviceStats[service];
+    if (++stats.missedDeadlines >= s_maxMissedDeadlines) {
+        qCWarning(KRUNNER) << service << "missed the deadline" << stats.missedDeadlines << "times in a row (average latency:" << stats.averageLatency
+                           << "ms), it is not queried for" << s_quarantineDuration << "ms";
+        stats.missedDeadlines = 0;
+        stats.quarantine.start();
+    }
+}
+
+bool DBusRunner::isQuarantined(const QString &service)
+{
+    const auto it = m_serviceStats.find(service);
+    if (it == m_serviceStats.end() || !it->quarantine.isValid()) {
+        return false;
+    }
+    if (it->quarantine.hasExpired(s_quarantineDuration)) {
+        it->quarantine.invalidate(); // Give it another chance
+        return false;
+    }
+    return true;
+}
+
+void DBusRunner::connectMatchSignals(const QString &service)
+{
+    if (m_apiVersion < 3) {
+        return;
+    }
+    QDBusConnection bus = connection(service);
+    // Signals on a peer-to-peer connection have no sender
+    const QString sender = m_peerConnections.contains(service) ? QString() : service;
+    bus.connect(sender, m_path, m_ifaceName, QStringLiteral("MatchesAvailable"), this, SLOT(onMatchesAvailable(QDBusMessage)));
+    bus.connect(sender, m_path, m_ifaceName, QStringLiteral("MatchFinished"), this, SLOT(onMatchFinished(QDBusMessage)));
+}
+
+void DBusRunner::disconnectMatchSignals(const QString &service)
+{
+    if (m_apiVersion < 3) {
+        return;
+    }
+    QDBusConnection bus = connection(service);
+    const QString sender = m_peerConnections.contains(service) ? QString() : service;
+    bus.disconnect(sender, m_path, m_ifaceName, QStringLiteral("MatchesAvailable"), this, SLOT(onMatchesAvailable(QDBusMessage)));
+    bus.disconnect(sender, m_path, m_ifaceName, QStringLiteral("MatchFinished"), this, SLOT(onMatchFinished(QDBusMessage)));
+}
+
+void DBusRunner::startMatch(const QString &service,
+                            const KRunner::RunnerContext &context,
+                            const QVariantMap &hints,
+                            const std::shared_ptr<PendingJob> &job)
+{
+    cancelOutdatedQueries();
+
+    const QString queryId = QString::number(++m_lastQueryId);
+    m_pendingQueries.insert(queryId, PendingQuery{service, context, job});
+
+    auto startMatchMethod = createMethodCall(service, QStringLiteral("StartMatch"));
+    startMatchMethod.setArguments(QList<QVariant>({context.query(), queryId, hints}));
+    QDBusPendingReply<> reply = connection(service).asyncCall(startMatchMethod);
+    auto watcher = new QDBusPendingCallWatcher(reply);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service, queryId, reply, watcher]() {
+        watcher->deleteLater();
+        if (reply.isError()) {
+            qCWarning(KRUNNER) << "Error starting match; calling" << service << " :" << reply.error().name() << reply.error().message();
+            handlePeerError(service, reply.error());
+            finishQuery(queryId);
+        }
+    });
+
+    if (m_matchTimeout > 0) {
+        QTimer::singleShot(m_matchTimeout, this, [this, service, queryId]() {
+            if (m_pendingQueries.contains(queryId)) {
+                qCWarning(KRUNNER) << "Timeout while waiting for matches of" << service;
+                cancelQuery(queryId);
+            }
+        });
+    }
+}
+
+QVariantMap DBusRunner::matchHints(const KRunner::RunnerContext &context) const
+{
+    QVariantMap hints;
+    // Only the cap of the runner itself is known here, the limits of the models showing the results are not
+    if (const int maxResults = d->currentMaxResults(); maxResults > 0) {
+        hints.insert(QStringLiteral("MaxResults"), maxResults);
+    }
+    if (!m_previousQuery.isEmpty()) {
+        hints.insert(QStringLiteral("PreviousQuery"), m_previousQuery);
+    }
+    if (context.singleRunnerQueryMode()) {
+        hints.insert(QStringLiteral("SingleRunnerMode"), true);
+    }
+    return hints;
+}
+
+void DBusRunner::cancelOutdatedQueries()
+{
+    QStringList outdatedQueryIds;
+    for (auto it = m_pendingQueries.cbegin(), end = m_pendingQueries.cend(); it != end; ++it) {
+        if (!it->context.isValid()) {
+            outdatedQueryIds << it.key();
+        }
+    }
+    for (const QString &queryId : std::as_const(outdatedQueryIds)) {
+        cancelQuery(queryId);
+    }
+}
+
+void DBusRunner::cancelQuery(const QString &queryId)
+{
+    const auto it = m_pendingQueries.constFind(queryId);
+    if (it == m_pendingQueries.cend()) {
+        return;
+    }
+    auto cancelMethod = createMethodCall(it->service, QStringLiteral("Cancel"));
+    cancelMethod.setArguments(QList<QVariant>({queryId}));
+    connection(it->service).call(cancelMethod, QDBus::NoBlock);
+    finishQuery(queryId);
+}
+
+void DBusRunner::finishQuery(const QString &queryId)
+{
+    const auto it = m_pendingQueries.constFind(queryId);
+    if (it == m_pendingQueries.cend()) {
+        return;
+    }
+    const PendingQuery query = it.value();
+    m_pendingQueries.erase(it);
+    finishService(query.service, query.job);
+}
+
+void DBusRunner::onMatchesAvailable(const QDBusMessage &message)
+{
+    const QList<QVariant> arguments = message.arguments();
+    if (arguments.size() != 2) {
+        qCWarning(KRUNNER) << "Invalid arguments of MatchesAvailable signal from" << message.service();
+        return;
+    }
+    // The query might have been finished already or belong to an outdated context
+    const auto it = m_pendingQueries.find(arguments.at(0).toString());
+    if (it == m_pendingQueries.end() || !it->context.isValid()) {
+        return;
+    }
+    const QString queryId = it.key();
+    const QString service = it->service;
+    const auto remoteMatches = qdbus_cast<RemoteMatches2>(arguments.at(1));
+    const QStringList iconHandles = missingIconHandles(service, remoteMatches);
+    if (iconHandles.isEmpty()) {
+        addRemoteMatches(queryId, remoteMatches);
+        return;
+    }
+
+    ++it->pendingIconRequests;
+    auto getIconsMethod = createMethodCall(service, QStringLiteral("GetIcons"));
+    getIconsMethod.setArguments(QList<QVariant>({iconHandles}));
+    QDBusPendingReply<RemoteIcons> reply = connection(service).asyncCall(getIconsMethod, m_matchTimeout);
+    auto watcher = new QDBusPendingCallWatcher(reply);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, queryId, service, remoteMatches, reply, watcher]() {
+        watcher->deleteLater();
+        if (reply.isError()) {
+            qCWarning(KRUNNER) << "Error requesting icons; calling" << service << " :" << reply.error().name() << reply.error().message();
+        } else {
+            const RemoteIcons remoteIcons = reply.value();
+            auto &icons = m_remoteIcons[service];
+            // Runners are expected to reuse a small set of handles, start over if one keeps creating new ones
+            if (icons.size() + remoteIcons.size() > 512) {
+                icons.clear();
+            }
+            for (const RemoteIcon &remoteIcon : remoteIcons) {
+                icons.insert(remoteIcon.handle, decodeSharedImage(remoteIcon));
+            }
+        }
+
+        const auto it = m_pendingQueries.find(queryId);
+        if (it == m_pendingQueries.end()) {
+            return; // The query was cancelled in the meantime
+        }
+        --it->pendingIconRequests;
+        addRemoteMatches(queryId, remoteMatches);
+        if (it->finishRequested && it->pendingIconRequests == 0) {
+            finishQuery(queryId);
+        }
+    });
+}
+
+void DBusRunner::addRemoteMatches(const QString &queryId, const RemoteMatches2 &remoteMatches)
+{
+    auto it = m_pendingQueries.find(queryId);
+    if (it != m_pendingQueries.end() && it->context.isValid()) {
+        it->context.addMatches(convertMatches(it->service, remoteMatches));
+    }
+}
+
+QStringList DBusRunner::missingIconHandles(const QString &service, const RemoteMatches2 &remoteMatches) const
+{
+    QStringList iconHandles;
+    // Without file descriptor passing the matches fall back to their icon name
+    if (!(connection(service).connectionCapabilities() & QDBusConnection::UnixFileDescriptorPassing)) {
+        return iconHandles;
+    }
+    const auto icons = m_remoteIcons.value(service);
+    for (const RemoteMatch2 &match : remoteMatches) {
+        if (match.extras.isEmpty()) {
+            continue;
+        }
+        const QString iconHandle = match.extras.value(QStringLiteral("icon-handle")).toString();
+        if (!iconHandle.isEmpty() && !icons.contains(iconHandle) && !iconHandles.contains(iconHandle)) {
+            iconHandles << iconHandle;
+        }
+    }
+    return iconHandles;
+}
+
+static bool isSealed(int fd)
+{
+#ifdef F_GET_SEALS
+    // A file which may still shrink cannot be mapped, reading the mapping would crash with SIGBUS once the runner truncates it
+    const int seals = fcntl(fd, F_GET_SEALS);
+    return seals != -1 && (seals & (F_SEAL_SHRINK | F_SEAL_WRITE)) == (F_SEAL_SHRINK | F_SEAL_WRITE);
+#else
+    Q_UNUSED(fd)
+    return false;
+#endif
+}
+
+// Reads the pixels of a file the runner may still modify, a file that shrinks meanwhile results in an incomplete image
+static QByteArray readPixels(int fd, qint64 size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    qint64 total = 0;
+    while (total < size) {
+        const ssize_t count = pread(fd, data.data() + total, size - total, total);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        total += count;
+    }
+    data.truncate(total);
+    return data;
+}
+
+QImage DBusRunner::decodeSharedImage(const RemoteIcon &remoteIcon)
+{
+    QFile file;
+    if (!remoteIcon.data.isValid() || !file.open(remoteIcon.data.fileDescriptor(), QIODevice::ReadOnly)) {
+        qCWarning(KRUNNER) << "Invalid file descriptor for icon" << remoteIcon.handle;
+        return {};
+    }
+    // Nothing beyond the last line is needed, this also limits how much a broken runner can make us read
+    const qint64 expectedSize = remoteIcon.rowStride > 0 && remoteIcon.height > 0 ? qint64(remoteIcon.rowStride) * remoteIcon.height : 0;
+    const qint64 size = std::min({file.size(), expectedSize, qint64(64 * 1024 * 1024)});
+    if (size <= 0) {
+        qCWarning(KRUNNER) << "Invalid size of icon" << remoteIcon.handle;
+        return {};
+    }
+
+    RemoteImage remoteImage;
+    remoteImage.width = remoteIcon.width;
+    remoteImage.height = remoteIcon.height;
+    remoteImage.rowStride = remoteIcon.rowStride;
+    remoteImage.hasAlpha = remoteIcon.hasAlpha;
+    remoteImage.bitsPerSample = remoteIcon.bitsPerSample;
+    remoteImage.channels = remoteIcon.channels;
+    if (!isSealed(file.handle())) {
+        remoteImage.data = readPixels(file.handle(), size);
+        return decodeRemoteImage(remoteImage);
+    }
+
+    const uchar *pixels = file.map(0, size);
+    if (!pixels) {
+        qCWarning(KRUNNER) << "Could not map icon" << remoteIcon.handle << file.errorString();
+        return {};
+    }
+    // The pixels are read directly from the mapping, which is released when the file gets closed
+    remoteImage.data = QByteArray::fromRawData(reinterpret_cast<const char *>(pixels), size);
+    return decodeRemoteImage(remoteImage);
+}
+
+void DBusRunner::onMatchFinished(const QDBusMessage &message)
+{
+    const QList<QVariant> arguments = message.arguments();
+    if (arguments.isEmpty()) {
+        return;
+    }
+    const QString queryId = arguments.constFirst().toString();
+    if (const auto it = m_pendingQueries.find(queryId); it != m_pendingQueries.end() && it->pendingIconRequests > 0) {
+        it->finishRequested = true;
+    } else {
+        finishQuery(queryId);
+    }
 }
 
 void DBusRunner::run(const KRunner::RunnerContext & /*context*/, const KRunner::QueryMatch &match)
@@ -282,79 +1062,35 @@ void DBusRunner::run(const KRunner::RunnerContext & /*context*/, const KRunner::
         actionId = match.selectedAction().id();
     }
 
+    // Called from the thread of the RunnerManager, the calls are made on our own thread
     auto run = [this, service, matchId, actionId] {
-        auto runMethod = QDBusMessage::createMethodCall(service, m_path, m_ifaceName, QStringLiteral("Run"));
+        auto runMethod = createMethodCall(service, QStringLiteral("Run"));
         runMethod.setArguments(QList<QVariant>({matchId, actionId}));
-        QDBusConnection::sessionBus().call(runMethod, QDBus::NoBlock);
+        connection(service).call(runMethod, QDBus::NoBlock);
     };
 
     if (KWindowSystem::isPlatformWayland() && qGuiApp->focusWindow()) {
         auto tokenFuture = KWaylandExtras::xdgActivationToken(qGuiApp->focusWindow(), {});
         tokenFuture.then(this, [this, service, matchId, actionId, run](const QString &token) {
             if (!token.isEmpty()) {
-                auto activationTokenMethod = QDBusMessage::createMethodCall(service, m_path, m_ifaceName, QStringLiteral("SetActivationToken"));
+                auto activationTokenMethod = createMethodCall(service, QStringLiteral("SetActivationToken"));
                 activationTokenMethod.setArguments(QList<QVariant>{token});
-                QDBusConnection::sessionBus().call(activationTokenMethod, QDBus::NoBlock);
+                connection(service).call(activationTokenMethod, QDBus::NoBlock);
             }
             run();
         });
     } else {
-        run();
+        QMetaObject::invokeMethod(this, run);
     }
 }
 
-QImage DBusRunner::decodeImage(const RemoteImage &remoteImage)
+QByteArray DBusRunner::iconCacheKey(const RemoteImage &remoteImage)
 {
-    auto copyLineRGB32 = [](QRgb *dst, const char *src, int width) {
-        const char *end = src + width * 3;
-        for (; src != end; ++dst, src += 3) {
-            *dst = qRgb(src[0], src[1], src[2]);
-        }
-    };
-
-    auto copyLineARGB32 = [](QRgb *dst, const char *src, int width) {
-        const char *end = src + width * 4;
-        for (; src != end; ++dst, src += 4) {
-            *dst = qRgba(src[0], src[1], src[2], src[3]);
-        }
-    };
-
-    if (remoteImage.width <= 0 || remoteImage.width >= 2048 || remoteImage.height <= 0 || remoteImage.height >= 2048 || remoteImage.rowStride <= 0) {
-        qCWarning(KRUNNER) << "Invalid image metadata (width:" << remoteImage.width << "height:" << remoteImage.height << "rowStride:" << remoteImage.rowStride
-                           << ")";
-        return {};
-    }
-
-    QImage::Format format = QImage::Format_Invalid;
-    void (*copyFn)(QRgb *, const char *, int) = nullptr;
-    if (remoteImage.bitsPerSample == 8) {
-        if (remoteImage.channels == 4) {
-            format = QImage::Format_ARGB32;
-            copyFn = copyLineARGB32;
-        } else if (remoteImage.channels == 3) {
-            format = QImage::Format_RGB32;
-            copyFn = copyLineRGB32;
-        }
-    }
-    if (format == QImage::Format_Invalid) {
-        qCWarning(KRUNNER) << "Unsupported image format (hasAlpha:" << remoteImage.hasAlpha << "bitsPerSample:" << remoteImage.bitsPerSample
-                           << "channels:" << remoteImage.channels << ")";
-        return {};
-    }
-
-    QImage image(remoteImage.width, remoteImage.height, format);
-    const QByteArray pixels = remoteImage.data;
-    const char *ptr = pixels.data();
-    const char *end = ptr + pixels.length();
-    for (int y = 0; y < remoteImage.height; ++y, ptr += remoteImage.rowStride) {
-        if (Q_UNLIKELY(ptr + remoteImage.channels * remoteImage.width > end)) {
-            qCWarning(KRUNNER) << "Image data is incomplete. y:" << y << "height:" << remoteImage.height;
-            break;
-        }
-        copyFn(reinterpret_cast<QRgb *>(image.scanLine(y)), ptr, remoteImage.width);
-    }
-
-    return image;
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(remoteImage.data);
+    return QByteArrayLiteral("dbus:") + QByteArray::number(remoteImage.width) + 'x' + QByteArray::number(remoteImage.height) + ':'
+        + QByteArray::number(remoteImage.rowStride) + ':' + QByteArray::number(remoteImage.bitsPerSample) + ':' + QByteArray::number(remoteImage.channels)
+        + (remoteImage.hasAlpha ? ":alpha:" : ":opaque:") + hash.result().toHex();
 }
 }
 #include "moc_dbusrunner_p.cpp"
@@ -7,21 +7,63 @@
 #pragma once
 
 #include <KRunner/AbstractRunner>
+#include <KRunner/RunnerContext>
+
+#include <KConfigGroup>
 
 #include "dbusutils_p.h"
+#include <QDBusConnection>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QImage>
 #include <QList>
+#include <QMutex>
 #include <QSet>
 
+#include <memory>
+#include <set>
+
+class QDBusError;
+class QDBusMessage;
+
 namespace KRunner
 {
+class QueryMatchBuilder;
+
+// Names on the bus, shared by all DBus runners that use a wildcard service
+class DBusNameCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DBusNameCache *instance();
+
+    // The names are only complete once the initial list arrived
+    bool isReady() const;
+    QStringList names(const QString &prefix) const;
+
+Q_SIGNALS:
+    void ready();
+    void nameAdded(const QString &name);
+    void nameRemoved(const QString &name);
+
+private:
+    explicit DBusNameCache(const QDBusConnection &bus);
+    void onServiceOwnerChanged(const QString &serviceName, const QString &oldOwner, const QString &newOwner);
+
+    mutable QMutex m_mutex;
+    QSet<QString> m_names;
+    bool m_ready = false;
+};
+
+// Lives on the thread shared by all DBus runners of a RunnerManager, only run is called from the manager's thread
 class DBusRunner : public KRunner::AbstractRunner
 {
     Q_OBJECT
 
 public:
     explicit DBusRunner(QObject *parent, const KPluginMetaData &data);
+    ~DBusRunner() override;
 
     // matchInternal is overwritten. Meaning we do not need the original match
     void match(KRunner::RunnerContext &) override
@@ -32,22 +74,116 @@ public:
 
     Q_INVOKABLE void matchInternal(KRunner::RunnerContext context);
 
+    // Cancels the streamed queries of contexts that are no longer valid
+    void cancelOutdatedQueries();
+
+private Q_SLOTS:
+    void onMatchesAvailable(const QDBusMessage &message);
+    void onMatchFinished(const QDBusMessage &message);
+
 private:
+    // A match job of the RunnerManager, finished once all services replied or missed the deadline
+    struct PendingJob {
+        QString id;
+        std::set<QString> services;
+        QElapsedTimer elapsed;
+    };
+
+    // Latencies of a service, services that keep missing the deadline are not queried for a while
+    struct ServiceStats {
+        qint64 averageLatency = -1;
+        int missedDeadlines = 0;
+        QElapsedTimer quarantine;
+    };
+    static constexpr int s_maxMissedDeadlines = 3;
+    static constexpr qint64 s_quarantineDuration = 30000;
+
+    // A query started using StartMatch, whose results are reported using signals
+    struct PendingQuery {
+        QString service;
+        KRunner::RunnerContext context;
+        std::shared_ptr<PendingJob> job;
+        // Matches are only added once the icons they refer to arrived, MatchFinished is deferred until then
+        int pendingIconRequests = 0;
+        bool finishRequested = false;
+    };
+
+    // The peer-to-peer connection advertised by the service, the session bus otherwise
+    QDBusConnection connection(const QString &service) const;
+    QDBusMessage createMethodCall(const QString &service, const QString &method) const;
+    void connectToPeer(const QString &service, const QString &address);
+    void disconnectFromPeer(const QString &service);
+    void handlePeerError(const QString &service, const QDBusError &error);
+    void onServicesDiscovered(const QString &servicePrefix);
+    void addMatchingService(const QString &service);
+    void removeMatchingService(const QString &service);
+    void connectMatchSignals(const QString &service);
+    void disconnectMatchSignals(const QString &service);
+    void startMatch(const QString &service,
+                    const KRunner::RunnerContext &context,
+                    const QVariantMap &hints,
+                    const std::shared_ptr<PendingJob> &job);
+    // Hints passed to StartMatch of org.kde.krunner2, built once per query for all services
+    QVariantMap matchHints(const KRunner::RunnerContext &context) const;
+    void finishQuery(const QString &queryId);
+    void cancelQuery(const QString &queryId);
+    // inTime is false if the service is given up on because it missed the deadline
+    void finishService(const QString &service, const std::shared_ptr<PendingJob> &job, bool inTime = true);
+    void recordLatency(const QString &service, qint64 latency, bool inTime);
+    void recordMissedDeadline(const QString &service);
+    bool isQuarantined(const QString &service);
     // Returns RemoteActions with service name as key
     void requestActions();
     void requestActionsForService(const QString &service, const std::function<void()> &finishedCallback);
     QList<QueryMatch> convertMatches(const QString &service, const RemoteMatches &remoteMatches);
+    QList<QueryMatch> convertMatches(const QString &service, const RemoteMatches2 &remoteMatches);
+    KRunner::Actions requestedActions(const QString &service, const QStringList &actionIds) const;
+    static void setIconData(QueryMatchBuilder &match, const QVariant &iconData);
+    void addRemoteMatches(const QString &queryId, const RemoteMatches2 &remoteMatches);
+    QStringList missingIconHandles(const QString &service, const RemoteMatches2 &remoteMatches) const;
+    static QImage decodeSharedImage(const RemoteIcon &remoteIcon);
     void requestConfig();
-    static QImage decodeImage(const RemoteImage &remoteImage);
+    // Starts DBus-activatable services when a match session is prepared, so they are running once the user typed a query
+    void prewarmServices();
+    void applyConfig(const QString &service, const QVariantMap &config);
+    // Config and actions are cached across sessions for runners that provide a CacheKey in their config
+    KConfigGroup cacheGroup(const QString &service) const;
+    bool applyCachedConfig(const QString &service);
+    void writeCache(const QString &service, const QVariantMap &config);
+    void writeCachedActions(const QString &service, const KRunner::Actions &actions);
+    // Contains everything decodeRemoteImage depends on, icons with the same key are decoded only once
+    static QByteArray iconCacheKey(const RemoteImage &remoteImage);
+    const QDBusConnection m_bus;
     QSet<QString> m_matchingServices;
     QHash<QString, QList<KRunner::Action>> m_actions;
     const QString m_path;
     const bool m_hasUniqueResults;
     const bool m_requestActionsOnce;
+    // 1 for X-Plasma-API=DBus, the number for later versions like DBus2. Starting with DBus3 org.kde.krunner2 is used
+    const int m_apiVersion;
+    // Milliseconds after which a match request is given up, -1 for the DBus default
+    const int m_matchTimeout;
+    // Milliseconds after which the job of a wildcard runner finishes without the services that did not reply yet
+    const int m_serviceDeadline;
+    bool m_isWildcard = false;
     bool m_actionsForSessionRequested = false;
     bool m_matchWasCalled = false;
     bool m_callLifecycleMethods = false;
+    bool m_waitingForServices = false;
     const QString m_ifaceName;
     QSet<QString> m_requestedActionServices;
+    QSet<QString> m_cachedActionServices;
+    QHash<QString, QString> m_cacheKeys;
+    QHash<QString, PendingQuery> m_pendingQueries;
+    // Icons fetched using GetIcons, grouped by service and handle
+    QHash<QString, QHash<QString, QImage>> m_remoteIcons;
+    QHash<QString, ServiceStats> m_serviceStats;
+    quint64 m_lastQueryId = 0;
+    // Last query of the match session, runners may refine its results
+    QString m_previousQuery;
+    // Names of the peer-to-peer connections, by service
+    QHash<QString, QString> m_peerConnections;
+    // Services whose peer-to-peer connection is being set up on the thread pool
+    QSet<QString> m_connectingPeers;
 };
 }
@@ -11,8 +11,10 @@
 #include "action.h"
 #include <KRunner/QueryMatch>
 #include <QDBusArgument>
+#include <QDBusUnixFileDescriptor>
 #include <QList>
 #include <QString>
+#include <QStringList>
 #include <QVariantMap>
 
 struct RemoteMatch {
@@ -27,6 +29,25 @@ struct RemoteMatch {
 
 typedef QList<RemoteMatch> RemoteMatches;
 
+// Used by org.kde.krunner2, the common properties are part of the structure instead of the map
+struct RemoteMatch2 {
+    // sssidssasbasba{sv}
+    QString id;
+    QString text;
+    QString iconName;
+    int categoryRelevance = qToUnderlying(KRunner::QueryMatch::CategoryRelevance::Lowest);
+    qreal relevance = 0;
+    QString category;
+    QString subtext;
+    QStringList urls;
+    bool multiLine = false;
+    QStringList actions;
+    bool defaultActions = true;
+    QVariantMap extras;
+};
+
+typedef QList<RemoteMatch2> RemoteMatches2;
+
 struct RemoteImage {
     // iiibiiay (matching notification spec image-data attribute)
     int width = 0;
@@ -38,6 +59,21 @@ struct RemoteImage {
     QByteArray data;
 };
 
+// Icon that is shared by the runner using a file descriptor, see GetIcons of org.kde.krunner2
+struct RemoteIcon {
+    // siiibiih
+    QString handle;
+    int width = 0;
+    int height = 0;
+    int rowStride = 0;
+    bool hasAlpha = false;
+    int bitsPerSample = 0;
+    int channels = 0;
+    QDBusUnixFileDescriptor data;
+};
+
+typedef QList<RemoteIcon> RemoteIcons;
+
 inline QDBusArgument &operator<<(QDBusArgument &argument, const RemoteMatch &match)
 {
     argument.beginStructure();
@@ -65,6 +101,45 @@ inline const QDBusArgument &operator>>(const QDBusArgument &argument, RemoteMatc
     return argument;
 }
 
+inline QDBusArgument &operator<<(QDBusArgument &argument, const RemoteMatch2 &match)
+{
+    argument.beginStructure();
+    argument << match.id;
+    argument << match.text;
+    argument << match.iconName;
+    argument << match.categoryRelevance;
+    argument << match.relevance;
+    argument << match.category;
+    argument << match.subtext;
+    argument << match.urls;
+    argument << match.multiLine;
+    argument << match.actions;
+    argument << match.defaultActions;
+    argument << match.extras;
+    argument.endStructure();
+    return argument;
+}
+
+inline const QDBusArgument &operator>>(const QDBusArgument &argument, RemoteMatch2 &match)
+{
+    argument.beginStructure();
+    argument >> match.id;
+    argument >> match.text;
+    argument >> match.iconName;
+    argument >> match.categoryRelevance;
+    argument >> match.relevance;
+    argument >> match.category;
+    argument >> match.subtext;
+    argument >> match.urls;
+    argument >> match.multiLine;
+    argument >> match.actions;
+    argument >> match.defaultActions;
+    argument >> match.extras;
+    argument.endStructure();
+
+    return argument;
+}
+
 inline QDBusArgument &operator<<(QDBusArgument &argument, const KRunner::Action &action)
 {
     argument.beginStructure();
@@ -117,7 +192,41 @@ inline const QDBusArgument &operator>>(const QDBusArgument &argument, RemoteImag
     return argument;
 }
 
+inline QDBusArgument &operator<<(QDBusArgument &argument, const RemoteIcon &icon)
+{
+    argument.beginStructure();
+    argument << icon.handle;
+    argument << icon.width;
+    argument << icon.height;
+    argument << icon.rowStride;
+    argument << icon.hasAlpha;
+    argument << icon.bitsPerSample;
+    argument << icon.channels;
+    argument << icon.data;
+    argument.endStructure();
+    return argument;
+}
+
+inline const QDBusArgument &operator>>(const QDBusArgument &argument, RemoteIcon &icon)
+{
+    argument.beginStructure();
+    argument >> icon.handle;
+    argument >> icon.width;
+    argument >> icon.height;
+    argument >> icon.rowStride;
+    argument >> icon.hasAlpha;
+    argument >> icon.bitsPerSample;
+    argument >> icon.channels;
+    argument >> icon.data;
+    argument.endStructure();
+    return argument;
+}
+
 Q_DECLARE_METATYPE(QList<KRunner::Action>)
 Q_DECLARE_METATYPE(RemoteMatch)
 Q_DECLARE_METATYPE(RemoteMatches)
+Q_DECLARE_METATYPE(RemoteMatch2)
+Q_DECLARE_METATYPE(RemoteMatches2)
 Q_DECLARE_METATYPE(RemoteImage)
+Q_DECLARE_METATYPE(RemoteIcon)
+Q_DECLARE_METATYPE(RemoteIcons)
@@ -40,8 +40,14 @@ inline KPluginMetaData parseMetaDataFromDesktopFile(const QString &fileName)
 
     copyIfExists(grp, root, "X-Plasma-DBusRunner-Service");
     copyIfExists(grp, root, "X-Plasma-DBusRunner-Path");
+    copyIfExists(grp, root, "X-Plasma-DBusRunner-Match-Timeout", -1);
+    copyIfExists(grp, root, "X-Plasma-DBusRunner-Service-Deadline", 500);
+    copyIfExists(grp, root, "X-Plasma-LocalSocketRunner-Socket");
+    copyIfExists(grp, root, "X-Plasma-LocalSocketRunner-Match-Timeout", -1);
     copyIfExists(grp, root, "X-Plasma-Runner-Unique-Results", false);
     copyIfExists(grp, root, "X-Plasma-Runner-Weak-Results", false);
+    copyIfExists(grp, root, "X-Plasma-Runner-Url-Deduplication-Priority", -1);
+    copyIfExists(grp, root, "X-Plasma-Runner-Max-Results", 0);
     copyIfExists(grp, root, "X-Plasma-API");
     copyIfExists(grp, root, "X-Plasma-Request-Actions-Once", false);
     copyIfExists(grp, root, "X-Plasma-Runner-Min-Letter-Count", 0);
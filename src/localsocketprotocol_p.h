@@ -0,0 +1,101 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QtEndian>
+
+// Framing used by runners with X-Plasma-API=LocalSocket, see LocalSocketRunner.
+// Each frame is a big endian quint32 with the size of the payload followed by the payload, which is written
+// using QDataStream (version Qt_6_0) and starts with the quint8 message type.
+namespace KRunner::LocalSocketProtocol
+{
+enum class MessageType : quint8 {
+    // Sent by KRunner
+    Match = 1, // quint32 queryId, QString query
+    Cancel = 2, // quint32 queryId
+    Run = 3, // QString matchId
+    // Sent by the runner
+    MatchesAvailable = 10, // quint32 queryId, QList<Match> matches
+    MatchFinished = 11, // quint32 queryId
+};
+
+// Frames bigger than this are considered a protocol error
+constexpr quint32 maxFrameSize = 64 * 1024 * 1024;
+
+struct Match {
+    QString id;
+    QString text;
+    QString subtext;
+    QString iconName;
+    QString category;
+    QStringList urls;
+    double relevance = 0;
+    double categoryRelevance = 50;
+    bool multiLine = false;
+};
+
+inline QDataStream &operator<<(QDataStream &stream, const Match &match)
+{
+    return stream << match.id << match.text << match.subtext << match.iconName << match.category << match.urls << match.relevance << match.categoryRelevance
+                  << match.multiLine;
+}
+
+inline QDataStream &operator>>(QDataStream &stream, Match &match)
+{
+    return stream >> match.id >> match.text >> match.subtext >> match.iconName >> match.category >> match.urls >> match.relevance >> match.categoryRelevance
+        >> match.multiLine;
+}
+
+template<typename... Args>
+inline QByteArray frame(MessageType type, const Args &...args)
+{
+    QByteArray data(sizeof(quint32), Qt::Uninitialized);
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly | QIODevice::Append);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << quint8(type);
+        (stream << ... << args);
+    }
+    qToBigEndian<quint32>(data.size() - sizeof(quint32), data.data());
+    return data;
+}
+
+// Type of a frame created using frame()
+inline MessageType frameType(const QByteArray &frame)
+{
+    return MessageType(quint8(frame.at(sizeof(quint32))));
+}
+
+enum class FrameResult {
+    Complete,
+    Incomplete,
+    Invalid,
+};
+
+// Moves the payload of the first complete frame of buffer into payload
+inline FrameResult takeFrame(QByteArray &buffer, QByteArray &payload)
+{
+    if (buffer.size() < qsizetype(sizeof(quint32))) {
+        return FrameResult::Incomplete;
+    }
+    const quint32 size = qFromBigEndian<quint32>(buffer.constData());
+    if (size == 0 || size > maxFrameSize) {
+        return FrameResult::Invalid;
+    }
+    if (buffer.size() < qsizetype(sizeof(quint32) + size)) {
+        return FrameResult::Incomplete;
+    }
+    payload = buffer.mid(sizeof(quint32), size);
+    buffer.remove(0, sizeof(quint32) + size);
+    return FrameResult::Complete;
+}
+}
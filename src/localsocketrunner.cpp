@@ -0,0 +1,269 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "localsocketrunner_p.h"
+
+#include <QDir>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include "krunner_debug.h"
+#include "querymatchbuilder.h"
+
+namespace KRunner
+{
+using namespace LocalSocketProtocol;
+
+static QString socketName(const KPluginMetaData &data)
+{
+    const QString socket = data.value(QStringLiteral("X-Plasma-LocalSocketRunner-Socket"));
+    if (socket.isEmpty() || QDir::isAbsolutePath(socket)) {
+        return socket;
+    }
+    // Relative names are looked up in the runtime directory, like the sockets of most session services
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + QLatin1Char('/') + socket;
+}
+
+LocalSocketRunner::LocalSocketRunner(QObject *parent, const KPluginMetaData &data)
+    : KRunner::AbstractRunner(parent, data)
+    , m_socketName(socketName(data))
+    , m_matchTimeout(data.value(QStringLiteral("X-Plasma-LocalSocketRunner-Match-Timeout"), -1))
+{
+    if (m_socketName.isEmpty()) {
+        qCWarning(KRUNNER) << "Invalid entry:" << data;
+    }
+
+    // Load the runner syntaxes
+    const QStringList syntaxes = data.value(QStringLiteral("X-Plasma-Runner-Syntaxes"), QStringList());
+    const QStringList syntaxDescriptions = data.value(QStringLiteral("X-Plasma-Runner-Syntax-Descriptions"), QStringList());
+    const int descriptionCount = syntaxDescriptions.count();
+    for (int i = 0; i < syntaxes.count(); ++i) {
+        const QString &query = syntaxes.at(i);
+        const QString description = i < descriptionCount ? syntaxDescriptions.at(i) : QString();
+        addSyntax(query, description);
+    }
+}
+
+bool LocalSocketRunner::ensureConnected()
+{
+    if (m_socket && m_socket->state() != QLocalSocket::UnconnectedState) {
+        return true;
+    }
+    if (m_socketName.isEmpty()) {
+        return false;
+    }
+    if (!m_socket) {
+        // Created lazily, so that the socket lives in the thread of the runner
+        m_socket = new QLocalSocket(this);
+        connect(m_socket, &QLocalSocket::connected, this, &LocalSocketRunner::onConnected);
+        connect(m_socket, &QLocalSocket::errorOccurred, this, &LocalSocketRunner::onErrorOccurred);
+        connect(m_socket, &QLocalSocket::readyRead, this, &LocalSocketRunner::onReadyRead);
+        connect(m_socket, &QLocalSocket::disconnected, this, &LocalSocketRunner::onDisconnected);
+    }
+    m_buffer.clear();
+    // Does not block, a runner that is not listening is reported right away using errorOccurred
+    m_socket->connectToServer(m_socketName);
+    return m_socket->state() != QLocalSocket::UnconnectedState;
+}
+
+void LocalSocketRunner::send(const QByteArray &frame)
+{
+    if (!ensureConnected()) {
+        if (frameType(frame) == MessageType::Run) {
+            qCWarning(KRUNNER) << "Could not run the match, no connection to" << m_socketName;
+        }
+        return;
+    }
+    if (m_socket->state() == QLocalSocket::ConnectedState) {
+        m_socket->write(frame);
+    } else {
+        m_outgoingFrames.append(frame);
+    }
+}
+
+void LocalSocketRunner::dropOutgoingFrames()
+{
+    for (const QByteArray &frame : std::as_const(m_outgoingFrames)) {
+        if (frameType(frame) == MessageType::Run) {
+            qCWarning(KRUNNER) << "Could not run the match, the connection to" << m_socketName << "failed";
+        }
+    }
+    m_outgoingFrames.clear();
+}
+
+void LocalSocketRunner::onConnected()
+{
+    for (const QByteArray &frame : std::as_const(m_outgoingFrames)) {
+        m_socket->write(frame);
+    }
+    m_outgoingFrames.clear();
+}
+
+void LocalSocketRunner::onErrorOccurred(QLocalSocket::LocalSocketError error)
+{
+    // Errors of an established connection are handled once it is disconnected
+    if (error == QLocalSocket::PeerClosedError || m_socket->state() != QLocalSocket::UnconnectedState) {
+        return;
+    }
+    qCWarning(KRUNNER) << "Could not connect to" << m_socketName << ":" << m_socket->errorString();
+    dropOutgoingFrames();
+    onDisconnected();
+}
+
+void LocalSocketRunner::matchInternal(KRunner::RunnerContext context)
+{
+    const QString jobId = context.runnerJobId(this);
+    cancelOutdatedQueries();
+    if (!ensureConnected()) {
+        Q_EMIT matchInternalFinished(jobId);
+        return;
+    }
+
+    const quint32 queryId = ++m_lastQueryId;
+    m_pendingQueries.insert(queryId, PendingQuery{context, jobId});
+    send(frame(MessageType::Match, queryId, context.query()));
+
+    if (m_matchTimeout > 0) {
+        QTimer::singleShot(m_matchTimeout, this, [this, queryId]() {
+            if (m_pendingQueries.contains(queryId)) {
+                qCWarning(KRUNNER) << "Timeout while waiting for matches of" << m_socketName;
+                cancelQuery(queryId);
+            }
+        });
+    }
+}
+
+void LocalSocketRunner::cancelOutdatedQueries()
+{
+    QList<quint32> outdatedQueryIds;
+    for (auto it = m_pendingQueries.cbegin(), end = m_pendingQueries.cend(); it != end; ++it) {
+        if (!it->context.isValid()) {
+            outdatedQueryIds << it.key();
+        }
+    }
+    for (quint32 queryId : std::as_const(outdatedQueryIds)) {
+        cancelQuery(queryId);
+    }
+}
+
+void LocalSocketRunner::cancelQuery(quint32 queryId)
+{
+    if (!m_pendingQueries.contains(queryId)) {
+        return;
+    }
+    if (m_socket && m_socket->state() != QLocalSocket::UnconnectedState) {
+        send(frame(MessageType::Cancel, queryId));
+    }
+    finishQuery(queryId);
+}
+
+void LocalSocketRunner::finishQuery(quint32 queryId)
+{
+    const auto it = m_pendingQueries.constFind(queryId);
+    if (it == m_pendingQueries.cend()) {
+        return;
+    }
+    const QString jobId = it->jobId;
+    m_pendingQueries.erase(it);
+    Q_EMIT matchInternalFinished(jobId);
+}
+
+void LocalSocketRunner::onReadyRead()
+{
+    m_buffer.append(m_socket->readAll());
+    QByteArray payload;
+    while (true) {
+        const FrameResult result = takeFrame(m_buffer, payload);
+        if (result == FrameResult::Incomplete) {
+            return;
+        }
+        if (result == FrameResult::Invalid || !handleFrame(payload)) {
+            qCWarning(KRUNNER) << "Invalid data received from" << m_socketName << ", closing the connection";
+            m_socket->abort();
+            onDisconnected();
+            return;
+        }
+    }
+}
+
+bool LocalSocketRunner::handleFrame(const QByteArray &payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint8 type = 0;
+    quint32 queryId = 0;
+    stream >> type >> queryId;
+
+    switch (MessageType(type)) {
+    case MessageType::MatchesAvailable: {
+        const auto it = m_pendingQueries.find(queryId);
+        if (it == m_pendingQueries.end() || !it->context.isValid()) {
+            // Results of cancelled or outdated queries are dropped before converting them
+            return stream.status() == QDataStream::Ok;
+        }
+        QList<Match> matches;
+        stream >> matches;
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+        it->context.addMatches(convertMatches(matches));
+        return true;
+    }
+    case MessageType::MatchFinished:
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+        finishQuery(queryId);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void LocalSocketRunner::onDisconnected()
+{
+    m_buffer.clear();
+    // The queries cannot be answered anymore, the next query reconnects
+    const QList<quint32> queryIds = m_pendingQueries.keys();
+    for (quint32 queryId : queryIds) {
+        finishQuery(queryId);
+    }
+}
+
+QList<QueryMatch> LocalSocketRunner::convertMatches(const QList<Match> &remoteMatches)
+{
+    QList<QueryMatch> matches;
+    matches.reserve(remoteMatches.size());
+    for (const Match &match : remoteMatches) {
+        KRunner::QueryMatchBuilder m(this);
+        m.setId(match.id);
+        m.setData(match.id);
+        m.setText(match.text);
+        m.setSubtext(match.subtext);
+        m.setIconName(match.iconName);
+        m.setMatchCategory(match.category);
+        m.setUrls(QUrl::fromStringList(match.urls));
+        m.setRelevance(match.relevance);
+        m.setCategoryRelevance(match.categoryRelevance);
+        m.setMultiLine(match.multiLine);
+        matches.append(m.build());
+    }
+    return matches;
+}
+
+void LocalSocketRunner::run(const KRunner::RunnerContext & /*context*/, const KRunner::QueryMatch &match)
+{
+    // The protocol has no actions, only the match itself can be run
+    const QString matchId = match.data().toString();
+    // Called from the thread of the RunnerManager, the socket lives on our own thread
+    QMetaObject::invokeMethod(this, [this, matchId]() {
+        send(frame(MessageType::Run, matchId));
+    });
+}
+}
+
+#include "moc_localsocketrunner_p.cpp"
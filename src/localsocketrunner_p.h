@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <KRunner/AbstractRunner>
+#include <KRunner/RunnerContext>
+
+#include "localsocketprotocol_p.h"
+#include <QHash>
+#include <QLocalSocket>
+
+namespace KRunner
+{
+// Runner for X-Plasma-API=LocalSocket, which talks to a process listening on X-Plasma-LocalSocketRunner-Socket
+// using the binary framing from localsocketprotocol_p.h instead of DBus. The connection is kept open across queries.
+// The metadata is installed to krunner/dbusplugins like the one of DBus runners.
+// Lives on the thread shared by the remote runners of a RunnerManager, only run is called from the manager's thread
+class LocalSocketRunner : public KRunner::AbstractRunner
+{
+    Q_OBJECT
+
+public:
+    explicit LocalSocketRunner(QObject *parent, const KPluginMetaData &data);
+
+    // matchInternal is overwritten. Meaning we do not need the original match
+    void match(KRunner::RunnerContext &) override
+    {
+    }
+    void run(const KRunner::RunnerContext &context, const KRunner::QueryMatch &match) override;
+
+    Q_INVOKABLE void matchInternal(KRunner::RunnerContext context);
+
+    // Cancels the queries of contexts that are no longer valid
+    void cancelOutdatedQueries();
+
+private:
+    struct PendingQuery {
+        KRunner::RunnerContext context;
+        QString jobId;
+    };
+
+    // Starts connecting if needed, returns false if the runner cannot be reached
+    bool ensureConnected();
+    // Frames are queued while connecting
+    void send(const QByteArray &frame);
+    void dropOutgoingFrames();
+    void onConnected();
+    void onErrorOccurred(QLocalSocket::LocalSocketError error);
+    void onReadyRead();
+    void onDisconnected();
+    bool handleFrame(const QByteArray &payload);
+    QList<QueryMatch> convertMatches(const QList<LocalSocketProtocol::Match> &remoteMatches);
+    void cancelQuery(quint32 queryId);
+    void finishQuery(quint32 queryId);
+
+    const QString m_socketName;
+    // Milliseconds after which a query is given up, -1 to wait until the runner finishes it
+    const int m_matchTimeout;
+    QLocalSocket *m_socket = nullptr;
+    QByteArray m_buffer;
+    QList<QByteArray> m_outgoingFrames;
+    QHash<quint32, PendingQuery> m_pendingQueries;
+    quint32 m_lastQueryId = 0;
+};
+}
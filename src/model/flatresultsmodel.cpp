@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDE Contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ *
+ */
+
+#include "flatresultsmodel_p.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "matchesdiff_p.h"
+#include "runnerresultsmodel_p.h"
+
+namespace KRunner
+{
+FlatResultsModel::FlatResultsModel(RunnerResultsModel *resultsModel, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_resultsModel(resultsModel)
+{
+    // The RunnerResultsModel emits matchesChanged once all categories are updated
+    connect(m_resultsModel, &RunnerResultsModel::matchesChanged, this, &FlatResultsModel::update);
+    connect(m_resultsModel, &QAbstractItemModel::modelReset, this, &FlatResultsModel::update);
+}
+
+int FlatResultsModel::limit() const
+{
+    return m_limit;
+}
+
+void FlatResultsModel::setLimit(int limit)
+{
+    if (m_limit == limit) {
+        return;
+    }
+    m_limit = limit;
+    update();
+    Q_EMIT limitChanged();
+}
+
+int FlatResultsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_matches.size());
+}
+
+QVariant FlatResultsModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid)) {
+        return {};
+    }
+    return RunnerResultsModel::matchData(m_matches.at(index.row()), role);
+}
+
+KRunner::QueryMatch FlatResultsModel::fetchMatch(const QModelIndex &idx) const
+{
+    return m_matches.value(idx.row());
+}
+
+void FlatResultsModel::update()
+{
+    const QStringList categories = m_resultsModel->categories();
+
+    struct Category {
+        QList<KRunner::QueryMatch> matches;
+        int favoriteIndex;
+        int relevance;
+    };
+    QList<Category> sortedCategories;
+    sortedCategories.reserve(categories.size());
+    int matchCount = 0;
+    for (int row = 0; row < categories.size(); ++row) {
+        Category c{m_resultsModel->matches(categories.at(row)), m_resultsModel->categoryFavoriteIndex(row), m_resultsModel->categoryRelevance(row)};
+        matchCount += c.matches.size();
+        sortedCategories.append(std::move(c));
+    }
+
+    // Favorites first, then by category relevance. Categories which are equal keep their order, like they do in the SortProxyModel
+    std::stable_sort(sortedCategories.begin(), sortedCategories.end(), [](const Category &a, const Category &b) {
+        if (a.favoriteIndex != b.favoriteIndex) {
+            return a.favoriteIndex < b.favoriteIndex;
+        }
+        return a.relevance > b.relevance;
+    });
+
+    // Each category may occupy a maximum of 1/(n+1) of the limit, but at least one match is shown per category.
+    // This is the same distribution as the one of the CategoryDistributionProxyModel
+    QList<KRunner::QueryMatch> newMatches;
+    newMatches.reserve(m_limit > 0 ? std::min(m_limit, matchCount) : matchCount);
+    const qsizetype categoryCount = sortedCategories.size();
+    int itemsBefore = 0;
+    for (qsizetype i = 0; i < categoryCount; ++i) {
+        const QList<KRunner::QueryMatch> &matches = sortedCategories.at(i).matches;
+        qsizetype maxItemsInCategory = matches.size();
+        if (m_limit > 0) {
+            maxItemsInCategory = m_limit;
+            if (categoryCount > 1) {
+                const int availableSpace = m_limit - itemsBefore - std::ceil(m_limit / qreal(categoryCount));
+                maxItemsInCategory = std::max(1, std::min(availableSpace, int(std::ceil(m_limit / qreal(i + 2)))));
+                itemsBefore += std::min(int(matches.size()), int(maxItemsInCategory));
+            }
+        }
+        newMatches.append(matches.first(std::min(matches.size(), maxItemsInCategory)));
+    }
+
+    updateMatches(this, QModelIndex(), m_matches, newMatches);
+}
+}
+
+#include "moc_flatresultsmodel_p.cpp"
@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDE Contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ *
+ */
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QList>
+
+#include <KRunner/QueryMatch>
+
+namespace KRunner
+{
+class RunnerResultsModel;
+
+/*
+ * Flat list of the matches of a RunnerResultsModel
+ *
+ * Does what the SortProxyModel, CategoryDistributionProxyModel, KDescendantsProxyModel and HideRootLevelProxyModel
+ * chain of the ResultsModel does, but in one pass over the categories each time the matches changed:
+ * the categories are sorted, the limit is distributed over them and their matches are concatenated.
+ */
+class FlatResultsModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit FlatResultsModel(RunnerResultsModel *resultsModel, QObject *parent = nullptr);
+
+    int limit() const;
+    void setLimit(int limit);
+    Q_SIGNAL void limitChanged();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    KRunner::QueryMatch fetchMatch(const QModelIndex &idx) const;
+
+private:
+    void update();
+    template<typename Model>
+    friend void updateMatches(Model *model, const QModelIndex &parent, QList<KRunner::QueryMatch> &oldMatches, const QList<KRunner::QueryMatch> &newMatches);
+
+    RunnerResultsModel *const m_resultsModel;
+    QList<KRunner::QueryMatch> m_matches;
+    int m_limit = 0;
+};
+}
@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDE Contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ *
+ */
+
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+#include <utility>
+
+#include <KRunner/QueryMatch>
+
+namespace KRunner
+{
+// Identifies a row by the id of its match and the number of rows before it with the same id. Runners without unique
+// results may use the same id, or none at all, for several matches, this way those are paired in their order
+using MatchKey = std::pair<QString, int>;
+
+inline QList<MatchKey> matchKeys(const QList<KRunner::QueryMatch> &matches)
+{
+    QHash<QString, int> occurrences;
+    QList<MatchKey> keys;
+    keys.reserve(matches.size());
+    for (const KRunner::QueryMatch &match : matches) {
+        const QString id = match.id();
+        keys.append(MatchKey(id, occurrences[id]++));
+    }
+    return keys;
+}
+
+/*
+ * Replaces the rows below parent, which hold oldMatches, with newMatches and emits the
+ * signals of the model for it. The rows are matched by their id, this way inserting a match
+ * at the front does not report all following rows as changed.
+ * Rows sharing an id are matched in the order they occur in.
+ *
+ * The model needs to befriend this function, the begin/end functions are protected.
+ */
+template<typename Model>
+void updateMatches(Model *model, const QModelIndex &parent, QList<KRunner::QueryMatch> &oldMatches, const QList<KRunner::QueryMatch> &newMatches)
+{
+    const QList<MatchKey> newKeys = matchKeys(newMatches);
+    const QSet<MatchKey> newKeySet(newKeys.cbegin(), newKeys.cend());
+    // Kept in sync with oldMatches
+    QList<MatchKey> oldKeys = matchKeys(oldMatches);
+
+    // Remove the rows that are gone, contiguous ones at once
+    QSet<MatchKey> remainingKeys;
+    remainingKeys.reserve(oldMatches.size());
+    QList<bool> keep(oldMatches.size());
+    for (int i = 0; i < oldMatches.size(); ++i) {
+        keep[i] = newKeySet.contains(oldKeys.at(i));
+        if (keep[i]) {
+            remainingKeys.insert(oldKeys.at(i));
+        }
+    }
+    for (int last = oldMatches.size() - 1; last >= 0; --last) {
+        if (keep.at(last)) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !keep.at(first - 1)) {
+            --first;
+        }
+        model->beginRemoveRows(parent, first, last);
+        oldMatches.remove(first, last - first + 1);
+        oldKeys.remove(first, last - first + 1);
+        model->endRemoveRows();
+        last = first;
+    }
+
+    // Walk the new order, moving existing rows into place and inserting runs of new ones
+    int firstChanged = -1;
+    const auto flushChanged = [model, &parent, &firstChanged](int end) {
+        if (firstChanged != -1) {
+            Q_EMIT model->dataChanged(model->index(firstChanged, 0, parent), model->index(end - 1, 0, parent));
+            firstChanged = -1;
+        }
+    };
+    for (int i = 0; i < newMatches.size();) {
+        const KRunner::QueryMatch &newMatch = newMatches.at(i);
+        const MatchKey &key = newKeys.at(i);
+        if (!remainingKeys.contains(key)) {
+            flushChanged(i);
+            int end = i + 1;
+            while (end < newMatches.size() && !remainingKeys.contains(newKeys.at(end))) {
+                ++end;
+            }
+            model->beginInsertRows(parent, i, end - 1);
+            for (int j = i; j < end; ++j) {
+                oldMatches.insert(j, newMatches.at(j));
+                oldKeys.insert(j, newKeys.at(j));
+            }
+            model->endInsertRows();
+            i = end;
+            continue;
+        }
+
+        if (oldKeys.at(i) != key) {
+            flushChanged(i);
+            int from = i + 1;
+            while (oldKeys.at(from) != key) {
+                ++from;
+            }
+            model->beginMoveRows(parent, from, from, parent, i);
+            oldMatches.move(from, i);
+            oldKeys.move(from, i);
+            model->endMoveRows();
+        }
+        remainingKeys.remove(key);
+
+        if (oldMatches.at(i) != newMatch) {
+            oldMatches[i] = newMatch;
+            if (firstChanged == -1) {
+                firstChanged = i;
+            }
+        } else {
+            flushChanged(i);
+        }
+        ++i;
+    }
+    flushChanged(newMatches.size());
+    Q_ASSERT(oldMatches.size() == newMatches.size());
+}
+}
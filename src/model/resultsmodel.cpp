@@ -9,6 +9,7 @@
 
 #include "resultsmodel.h"
 
+#include "flatresultsmodel_p.h"
 #include "runnerresultsmodel_p.h"
 
 #include <QIdentityProxyModel>
@@ -41,6 +42,28 @@ public:
         sort(0, Qt::DescendingOrder);
     }
 
+    void setSourceModel(QAbstractItemModel *sourceModel) override
+    {
+        if (this->sourceModel()) {
+            disconnect(this->sourceModel(), nullptr, this, nullptr);
+        }
+        m_resultsModel = qobject_cast<RunnerResultsModel *>(sourceModel);
+        Q_ASSERT(!sourceModel || m_resultsModel);
+        m_categoryKeys.clear();
+
+        // Connected before the base class does, so that the keys are invalidated before it sorts again
+        if (sourceModel) {
+            connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &SortProxyModel::invalidateKeys);
+            connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &SortProxyModel::invalidateKeys);
+            connect(sourceModel, &QAbstractItemModel::rowsMoved, this, &SortProxyModel::invalidateKeys);
+            connect(sourceModel, &QAbstractItemModel::dataChanged, this, &SortProxyModel::invalidateKeys);
+            connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &SortProxyModel::invalidateKeys);
+            connect(sourceModel, &QAbstractItemModel::modelReset, this, &SortProxyModel::invalidateKeys);
+        }
+
+        QSortFilterProxyModel::setSourceModel(sourceModel);
+    }
+
     void setQueryString(const QString &queryString)
     {
         const QStringList words = queryString.split(QLatin1Char(' '), Qt::SkipEmptyParts);
@@ -57,27 +80,50 @@ protected:
         Q_ASSERT((bool)sourceA.internalId() == (bool)sourceB.internalId());
         // Only check the favorite index if we compare categories. For individual matches, they will always be the same
         if (isCategoryComparison) {
-            const int favoriteA = sourceA.data(ResultsModel::FavoriteIndexRole).toInt();
-            const int favoriteB = sourceB.data(ResultsModel::FavoriteIndexRole).toInt();
-            if (favoriteA != favoriteB) {
-                return favoriteA > favoriteB;
+            const CategoryKey &keyA = categoryKey(sourceA.row());
+            const CategoryKey &keyB = categoryKey(sourceB.row());
+            if (keyA.favoriteIndex != keyB.favoriteIndex) {
+                return keyA.favoriteIndex > keyB.favoriteIndex;
             }
-
-            const int typeA = sourceA.data(ResultsModel::CategoryRelevanceRole).toInt();
-            const int typeB = sourceB.data(ResultsModel::CategoryRelevanceRole).toInt();
-            return typeA < typeB;
+            return keyA.relevance < keyB.relevance;
         }
 
-        const qreal relevanceA = sourceA.data(ResultsModel::RelevanceRole).toReal();
-        const qreal relevanceB = sourceB.data(ResultsModel::RelevanceRole).toReal();
+        // The RunnerResultsModel already provides the matches of a category ordered by their relevance and text
+        return sourceA.row() > sourceB.row();
+    }
 
-        if (!qFuzzyCompare(relevanceA, relevanceB)) {
-            return relevanceA < relevanceB;
+private:
+    struct CategoryKey {
+        int favoriteIndex = 0;
+        int relevance = 0;
+        bool valid = false;
+    };
+
+    // The keys are computed once per category after the matches changed instead of on every comparison
+    const CategoryKey &categoryKey(int row) const
+    {
+        const int categoryCount = sourceModel()->rowCount();
+        if (m_categoryKeys.size() != categoryCount) {
+            m_categoryKeys.assign(categoryCount, CategoryKey{});
         }
+        CategoryKey &key = m_categoryKeys[row];
+        if (!key.valid) {
+            // Same values as the FavoriteIndexRole and CategoryRelevanceRole, without wrapping them in a QVariant
+            key.favoriteIndex = m_resultsModel->categoryFavoriteIndex(row);
+            key.relevance = m_resultsModel->categoryRelevance(row);
+            key.valid = true;
+        }
+        return key;
+    }
 
-        return QSortFilterProxyModel::lessThan(sourceA, sourceB);
+    void invalidateKeys()
+    {
+        m_categoryKeys.clear();
     }
 
+    RunnerResultsModel *m_resultsModel = nullptr;
+    mutable QList<CategoryKey> m_categoryKeys;
+
 public:
     QStringList m_words;
 };
@@ -228,6 +274,25 @@ public:
         : q(q)
         , resultsModel(new RunnerResultsModel(configGroup, stateConfigGroup, q))
     {
+        // The flat model does the work of the proxy chain in one pass, it is opt-in until it replaces the chain
+        if (qEnvironmentVariableIntValue("KRUNNER_FLAT_RESULTS_MODEL")) {
+            flatModel = new FlatResultsModel(resultsModel, q);
+        } else {
+            sortModel = new SortProxyModel(q);
+            distributionModel = new CategoryDistributionProxyModel(q);
+            flattenModel = new KDescendantsProxyModel(q);
+            hideRootModel = new HideRootLevelProxyModel(q);
+            mapper = std::make_unique<KModelIndexProxyMapper>(q, resultsModel);
+        }
+    }
+
+    KRunner::QueryMatch fetchMatch(const QModelIndex &idx) const
+    {
+        if (flatModel) {
+            return flatModel->fetchMatch(q->mapToSource(idx));
+        }
+        const QModelIndex resultIdx = mapper->mapLeftToRight(idx);
+        return resultIdx.isValid() ? resultsModel->fetchMatch(resultIdx) : QueryMatch();
     }
 
     ResultsModel *q;
@@ -235,11 +300,14 @@ public:
     QPointer<KRunner::AbstractRunner> runner = nullptr;
 
     RunnerResultsModel *const resultsModel;
-    SortProxyModel *const sortModel = new SortProxyModel(q);
-    CategoryDistributionProxyModel *const distributionModel = new CategoryDistributionProxyModel(q);
-    KDescendantsProxyModel *const flattenModel = new KDescendantsProxyModel(q);
-    HideRootLevelProxyModel *const hideRootModel = new HideRootLevelProxyModel(q);
-    const KModelIndexProxyMapper mapper{q, resultsModel};
+    // Either the flat model or the proxy chain is used
+    FlatResultsModel *flatModel = nullptr;
+    SortProxyModel *sortModel = nullptr;
+    CategoryDistributionProxyModel *distributionModel = nullptr;
+    KDescendantsProxyModel *flattenModel = nullptr;
+    HideRootLevelProxyModel *hideRootModel = nullptr;
+    // Only needed to map through the proxy chain
+    std::unique_ptr<KModelIndexProxyMapper> mapper;
 };
 
 ResultsModel::ResultsModel(QObject *parent)
@@ -257,33 +325,38 @@ ResultsModel::ResultsModel(const KConfigGroup &configGroup, const KConfigGroup &
         connect(runnerManager(), &RunnerManager::queryingChanged, this, &ResultsModel::queryingChanged);
     });
 
-    // The matches for the old query string remain on display until the first set of matches arrive for the new query string.
-    // Therefore we must not update the query string inside RunnerResultsModel exactly when the query string changes, otherwise it would
-    // re-sort the old query string matches based on the new query string.
-    // So we only make it aware of the query string change at the time when we receive the first set of matches for the new query string.
-    connect(d->resultsModel, &RunnerResultsModel::matchesChanged, this, [this]() {
-        d->sortModel->setQueryString(queryString());
-    });
+    if (d->flatModel) {
+        connect(d->flatModel, &FlatResultsModel::limitChanged, this, &ResultsModel::limitChanged);
+        setSourceModel(d->flatModel);
+    } else {
+        // The matches for the old query string remain on display until the first set of matches arrive for the new query string.
+        // Therefore we must not update the query string inside RunnerResultsModel exactly when the query string changes, otherwise it would
+        // re-sort the old query string matches based on the new query string.
+        // So we only make it aware of the query string change at the time when we receive the first set of matches for the new query string.
+        connect(d->resultsModel, &RunnerResultsModel::matchesChanged, this, [this]() {
+            d->sortModel->setQueryString(queryString());
+        });
 
-    connect(d->distributionModel, &CategoryDistributionProxyModel::limitChanged, this, &ResultsModel::limitChanged);
+        connect(d->distributionModel, &CategoryDistributionProxyModel::limitChanged, this, &ResultsModel::limitChanged);
 
-    // The data flows as follows:
-    // - RunnerResultsModel
-    //   - SortProxyModel
-    //     - CategoryDistributionProxyModel
-    //       - KDescendantsProxyModel
-    //         - HideRootLevelProxyModel
+        // The data flows as follows:
+        // - RunnerResultsModel
+        //   - SortProxyModel
+        //     - CategoryDistributionProxyModel
+        //       - KDescendantsProxyModel
+        //         - HideRootLevelProxyModel
 
-    d->sortModel->setSourceModel(d->resultsModel);
+        d->sortModel->setSourceModel(d->resultsModel);
 
-    d->distributionModel->setSourceModel(d->sortModel);
+        d->distributionModel->setSourceModel(d->sortModel);
 
-    d->flattenModel->setSourceModel(d->distributionModel);
+        d->flattenModel->setSourceModel(d->distributionModel);
 
-    d->hideRootModel->setSourceModel(d->flattenModel);
-    d->hideRootModel->setTreeModel(d->resultsModel);
+        d->hideRootModel->setSourceModel(d->flattenModel);
+        d->hideRootModel->setTreeModel(d->resultsModel);
 
-    setSourceModel(d->hideRootModel);
+        setSourceModel(d->hideRootModel);
+    }
 
     // Initialize the runners, this will speed the first query up.
     // While there were lots of optimizations, instantiating plugins, creating threads and AbstractRunner::init is still heavy work
@@ -317,12 +390,16 @@ void ResultsModel::setQueryString(const QString &queryString)
 
 int ResultsModel::limit() const
 {
-    return d->distributionModel->limit();
+    return d->flatModel ? d->flatModel->limit() : d->distributionModel->limit();
 }
 
 void ResultsModel::setLimit(int limit)
 {
-    d->distributionModel->setLimit(limit);
+    if (d->flatModel) {
+        d->flatModel->setLimit(limit);
+    } else {
+        d->distributionModel->setLimit(limit);
+    }
 }
 
 void ResultsModel::resetLimit()
@@ -378,28 +455,18 @@ void ResultsModel::clear()
 
 bool ResultsModel::run(const QModelIndex &idx)
 {
-    KModelIndexProxyMapper mapper(this, d->resultsModel);
-    const QModelIndex resultsIdx = mapper.mapLeftToRight(idx);
-    if (!resultsIdx.isValid()) {
-        return false;
-    }
-    return d->resultsModel->run(resultsIdx);
+    return d->resultsModel->run(d->fetchMatch(idx));
 }
 
 bool ResultsModel::runAction(const QModelIndex &idx, int actionNumber)
 {
-    KModelIndexProxyMapper mapper(this, d->resultsModel);
-    const QModelIndex resultsIdx = mapper.mapLeftToRight(idx);
-    if (!resultsIdx.isValid()) {
-        return false;
-    }
-    return d->resultsModel->runAction(resultsIdx, actionNumber);
+    return d->resultsModel->runAction(d->fetchMatch(idx), actionNumber);
 }
 
 QMimeData *ResultsModel::getMimeData(const QModelIndex &idx) const
 {
-    if (auto resultIdx = d->mapper.mapLeftToRight(idx); resultIdx.isValid()) {
-        return runnerManager()->mimeDataForMatch(d->resultsModel->fetchMatch(resultIdx));
+    if (const QueryMatch match = d->fetchMatch(idx); match.isValid()) {
+        return runnerManager()->mimeDataForMatch(match);
     }
     return nullptr;
 }
@@ -411,8 +478,7 @@ KRunner::RunnerManager *ResultsModel::runnerManager() const
 
 KRunner::QueryMatch ResultsModel::getQueryMatch(const QModelIndex &idx) const
 {
-    const QModelIndex resultIdx = d->mapper.mapLeftToRight(idx);
-    return resultIdx.isValid() ? d->resultsModel->fetchMatch(resultIdx) : QueryMatch();
+    return d->fetchMatch(idx);
 }
 
 void ResultsModel::setRunnerManager(KRunner::RunnerManager *manager)
@@ -10,8 +10,11 @@
 #include <QIcon>
 #include <QSet>
 
+#include <algorithm>
+
 #include <KRunner/RunnerManager>
 
+#include "matchesdiff_p.h"
 #include "resultsmodel.h"
 
 namespace KRunner
@@ -38,10 +41,34 @@ void RunnerResultsModel::onMatchesChanged(const QList<KRunner::QueryMatch> &matc
     // Below when we populate the actual m_matches we'll make sure to keep the order
     // of existing categories to avoid pointless model changes.
     QHash<QString /*category*/, QList<KRunner::QueryMatch>> newMatches;
+    // Categories are interned by QueryMatch and consecutive matches mostly share one,
+    // comparing the string data by pointer avoids hashing the category for every match
+    QString previousCategory;
+    QList<KRunner::QueryMatch> *previousCategoryMatches = nullptr;
     for (const auto &match : matches) {
         const QString category = match.matchCategory();
-        newCategories.insert(category);
-        newMatches[category].append(match);
+        if (!previousCategoryMatches || category.constData() != previousCategory.constData() || category.size() != previousCategory.size()) {
+            newCategories.insert(category);
+            previousCategory = category;
+            previousCategoryMatches = &newMatches[category];
+        }
+        previousCategoryMatches->append(match);
+    }
+
+    // The RunnerContext orders the matches by category relevance and relevance. Only if the matches within
+    // one category have a different category relevance or the same relevance, they need to be reordered.
+    // This way the rows within a category are already in their final order and do not need to be sorted again.
+    // Matches with the same relevance are ordered by their text, descending like the sorting of the DisplayRole did
+    const auto isMoreRelevant = [](const KRunner::QueryMatch &a, const KRunner::QueryMatch &b) {
+        if (a.relevance() != b.relevance()) {
+            return a.relevance() > b.relevance();
+        }
+        return a.text() > b.text();
+    };
+    for (auto &matchesInCategory : newMatches) {
+        if (!std::is_sorted(matchesInCategory.cbegin(), matchesInCategory.cend(), isMoreRelevant)) {
+            std::stable_sort(matchesInCategory.begin(), matchesInCategory.end(), isMoreRelevant);
+        }
     }
 
     // Get rid of all categories that are no longer present
@@ -72,44 +99,8 @@ void RunnerResultsModel::onMatchesChanged(const QList<KRunner::QueryMatch> &matc
         auto oldCategoryIt = m_matches.find(*it);
         Q_ASSERT(oldCategoryIt != m_matches.end());
 
-        auto &oldMatchesInCategory = *oldCategoryIt;
-        const auto newMatchesInCategory = newMatches.value(*it);
-
-        Q_ASSERT(!oldMatchesInCategory.isEmpty());
-        Q_ASSERT(!newMatches.isEmpty());
-
-        // Emit a change for all existing matches if any of them changed
-        // TODO only emit a change for the ones that changed
-        bool emitDataChanged = false;
-
-        const int oldCount = oldMatchesInCategory.count();
-        const int newCount = newMatchesInCategory.count();
-
-        const int countCeiling = std::min(oldCount, newCount);
-
-        for (int i = 0; i < countCeiling; ++i) {
-            auto &oldMatch = oldMatchesInCategory[i];
-            if (oldMatch != newMatchesInCategory.at(i)) {
-                oldMatch = newMatchesInCategory.at(i);
-                emitDataChanged = true;
-            }
-        }
-
-        // Now that the source data has been updated, emit the data changes we noted down earlier
-        if (emitDataChanged) {
-            Q_EMIT dataChanged(index(0, 0, categoryIdx), index(countCeiling - 1, 0, categoryIdx));
-        }
-
-        // Signal insertions for any new items
-        if (newCount > oldCount) {
-            beginInsertRows(categoryIdx, oldCount, newCount - 1);
-            oldMatchesInCategory = newMatchesInCategory;
-            endInsertRows();
-        } else if (newCount < oldCount) {
-            beginRemoveRows(categoryIdx, newCount, oldCount - 1);
-            oldMatchesInCategory = newMatchesInCategory;
-            endRemoveRows();
-        }
+        Q_ASSERT(!oldCategoryIt->isEmpty());
+        updateMatches(this, categoryIdx, *oldCategoryIt, newMatches.value(*it));
 
         // Remove it from the "new" categories so in the next step we can add all genuinely new categories in one go
         newCategories.remove(*it);
@@ -179,18 +170,16 @@ void RunnerResultsModel::clear()
     m_hasMatches = false;
 }
 
-bool RunnerResultsModel::run(const QModelIndex &idx)
+bool RunnerResultsModel::run(const KRunner::QueryMatch &match)
 {
-    KRunner::QueryMatch match = fetchMatch(idx);
     if (match.isValid() && match.isEnabled()) {
         return m_manager->run(match);
     }
     return false;
 }
 
-bool RunnerResultsModel::runAction(const QModelIndex &idx, int actionNumber)
+bool RunnerResultsModel::runAction(const KRunner::QueryMatch &match, int actionNumber)
 {
-    KRunner::QueryMatch match = fetchMatch(idx);
     if (!match.isValid() || !match.isEnabled()) {
         return false;
     }
@@ -226,6 +215,88 @@ int RunnerResultsModel::rowCount(const QModelIndex &parent) const
     return m_matches.value(category).count();
 }
 
+QStringList RunnerResultsModel::categories() const
+{
+    return m_categories;
+}
+
+QList<KRunner::QueryMatch> RunnerResultsModel::matches(const QString &category) const
+{
+    return m_matches.value(category);
+}
+
+int RunnerResultsModel::categoryFavoriteIndex(int categoryRow) const
+{
+    const auto matches = m_matches.value(m_categories.value(categoryRow));
+    for (const KRunner::QueryMatch &match : matches) {
+        if (match.isValid()) {
+            const int idx = m_favoriteIds.indexOf(match.runner()->id());
+            return idx == -1 ? int(m_favoriteIds.size()) : idx;
+        }
+    }
+    // Any match that is not a favorite will have a greater index than an actual favorite
+    return int(m_favoriteIds.size());
+}
+
+int RunnerResultsModel::categoryRelevance(int categoryRow) const
+{
+    // Returns the highest type/role within the group
+    int highestType = 0;
+    const auto matches = m_matches.value(m_categories.value(categoryRow));
+    for (const KRunner::QueryMatch &match : matches) {
+        highestType = std::max(highestType, qRound(match.categoryRelevance()));
+    }
+    return highestType;
+}
+
+QVariant RunnerResultsModel::matchData(const KRunner::QueryMatch &match, int role)
+{
+    if (!match.isValid()) {
+        return {};
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return match.text();
+    case Qt::DecorationRole:
+        if (!match.iconName().isEmpty()) {
+            return match.iconName();
+        }
+        return match.icon();
+    case ResultsModel::CategoryRelevanceRole:
+        return match.categoryRelevance();
+    case ResultsModel::RelevanceRole:
+        return match.relevance();
+    case ResultsModel::IdRole:
+        return match.id();
+    case ResultsModel::EnabledRole:
+        return match.isEnabled();
+    case ResultsModel::CategoryRole:
+        return match.matchCategory();
+    case ResultsModel::SubtextRole:
+        return match.subtext();
+    case ResultsModel::UrlsRole:
+        return QVariant::fromValue(match.urls());
+    case ResultsModel::MultiLineRole:
+        return match.isMultiLine();
+    case ResultsModel::ActionsRole: {
+        const auto actions = match.actions();
+        QVariantList actionsList;
+        actionsList.reserve(actions.size());
+
+        for (const KRunner::Action &action : actions) {
+            actionsList.append(QVariant::fromValue(action));
+        }
+
+        return actionsList;
+    }
+    case ResultsModel::QueryMatchRole:
+        return QVariant::fromValue(match);
+    }
+
+    return {};
+}
+
 QVariant RunnerResultsModel::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid()) {
@@ -237,51 +308,7 @@ QVariant RunnerResultsModel::data(const QModelIndex &index, int role) const
             return {};
         }
 
-        KRunner::QueryMatch match = fetchMatch(index);
-        if (!match.isValid()) {
-            return {};
-        }
-
-        switch (role) {
-        case Qt::DisplayRole:
-            return match.text();
-        case Qt::DecorationRole:
-            if (!match.iconName().isEmpty()) {
-                return match.iconName();
-            }
-            return match.icon();
-        case ResultsModel::CategoryRelevanceRole:
-            return match.categoryRelevance();
-        case ResultsModel::RelevanceRole:
-            return match.relevance();
-        case ResultsModel::IdRole:
-            return match.id();
-        case ResultsModel::EnabledRole:
-            return match.isEnabled();
-        case ResultsModel::CategoryRole:
-            return match.matchCategory();
-        case ResultsModel::SubtextRole:
-            return match.subtext();
-        case ResultsModel::UrlsRole:
-            return QVariant::fromValue(match.urls());
-        case ResultsModel::MultiLineRole:
-            return match.isMultiLine();
-        case ResultsModel::ActionsRole: {
-            const auto actions = match.actions();
-            QVariantList actionsList;
-            actionsList.reserve(actions.size());
-
-            for (const KRunner::Action &action : actions) {
-                actionsList.append(QVariant::fromValue(action));
-            }
-
-            return actionsList;
-        }
-        case ResultsModel::QueryMatchRole:
-            return QVariant::fromValue(match);
-        }
-
-        return {};
+        return matchData(fetchMatch(index), role);
     }
 
     // category
@@ -293,29 +320,10 @@ QVariant RunnerResultsModel::data(const QModelIndex &index, int role) const
     case Qt::DisplayRole:
         return m_categories.at(index.row());
 
-    case ResultsModel::FavoriteIndexRole: {
-        for (int i = 0; i < rowCount(index); ++i) {
-            auto match = this->index(i, 0, index).data(ResultsModel::QueryMatchRole).value<KRunner::QueryMatch>();
-            if (match.isValid()) {
-                const QString id = match.runner()->id();
-                int idx = m_favoriteIds.indexOf(id);
-                return idx == -1 ? m_favoriteIds.size() : idx;
-            }
-        }
-        // Any match that is not a favorite will have a greater index than an actual favorite
-        return m_favoriteIds.size();
-    }
-    // Returns the highest type/role within the group
-    case ResultsModel::CategoryRelevanceRole: {
-        int highestType = 0;
-        for (int i = 0; i < rowCount(index); ++i) {
-            const int type = this->index(i, 0, index).data(ResultsModel::CategoryRelevanceRole).toInt();
-            if (type > highestType) {
-                highestType = type;
-            }
-        }
-        return highestType;
-    }
+    case ResultsModel::FavoriteIndexRole:
+        return categoryFavoriteIndex(index.row());
+    case ResultsModel::CategoryRelevanceRole:
+        return categoryRelevance(index.row());
     case ResultsModel::RelevanceRole: {
         qreal highestRelevance = 0.0;
         for (int i = 0; i < rowCount(index); ++i) {
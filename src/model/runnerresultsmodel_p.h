@@ -41,8 +41,8 @@ public:
      */
     void clear();
 
-    bool run(const QModelIndex &idx);
-    bool runAction(const QModelIndex &idx, int actionNumber);
+    bool run(const KRunner::QueryMatch &match);
+    bool runAction(const KRunner::QueryMatch &match, int actionNumber);
 
     int columnCount(const QModelIndex &parent) const override;
     int rowCount(const QModelIndex &parent) const override;
@@ -55,6 +55,15 @@ public:
     KRunner::RunnerManager *runnerManager() const;
     KRunner::QueryMatch fetchMatch(const QModelIndex &idx) const;
 
+    // The categories in the order of their rows and the matches of one, ordered by relevance
+    QStringList categories() const;
+    QList<KRunner::QueryMatch> matches(const QString &category) const;
+    // Values of the FavoriteIndexRole and CategoryRelevanceRole of a category row, without going through data()
+    int categoryFavoriteIndex(int categoryRow) const;
+    int categoryRelevance(int categoryRow) const;
+    // Value of role for a match row
+    static QVariant matchData(const KRunner::QueryMatch &match, int role);
+
     QStringList m_favoriteIds;
 Q_SIGNALS:
     void queryStringChangeRequested(const QString &queryString, int pos);
@@ -63,6 +72,8 @@ Q_SIGNALS:
 
 private:
     void onMatchesChanged(const QList<KRunner::QueryMatch> &matches);
+    template<typename Model>
+    friend void updateMatches(Model *model, const QModelIndex &parent, QList<KRunner::QueryMatch> &oldMatches, const QList<KRunner::QueryMatch> &newMatches);
 
     KRunner::RunnerManager *m_manager = nullptr;
     QString m_queryString;
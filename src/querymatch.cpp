@@ -6,83 +6,65 @@
 
 #include "querymatch.h"
 #include "action.h"
+#include "querymatch_p.h"
 
+#include <QCache>
 #include <QIcon>
-#include <QPointer>
-#include <QReadWriteLock>
-#include <QSharedData>
+#include <QMutex>
+#include <QSet>
 #include <QVariant>
 
 #include "abstractrunner.h"
-#include "abstractrunner_p.h"
 
 namespace KRunner
 {
-class QueryMatchPrivate : public QSharedData
+// Only a handful of categories exist in practice, the limit guards against runners creating one for each match
+static constexpr qsizetype maxInternedCategories = 512;
+
+QString QueryMatchPrivate::internedCategory(const QString &category)
 {
-public:
-    explicit QueryMatchPrivate(AbstractRunner *r)
-        : QSharedData()
-        , runner(r)
+    static QReadWriteLock lock;
+    static QSet<QString> categories;
+
+    if (category.isEmpty()) {
+        return category;
+    }
     {
+        QReadLocker locker(&lock);
+        if (auto it = categories.constFind(category); it != categories.cend()) {
+            return *it;
+        }
     }
+    QWriteLocker locker(&lock);
+    if (categories.size() >= maxInternedCategories) {
+        return category;
+    }
+    return *categories.insert(category);
+}
 
-    QueryMatchPrivate(const QueryMatchPrivate &other)
-        : QSharedData(other)
-    {
-        QReadLocker l(&other.lock);
-        runner = other.runner;
-        categoryRelevance = other.categoryRelevance;
-        relevance = other.relevance;
-        selAction = other.selAction;
-        enabled = other.enabled;
-        idSetByData = other.idSetByData;
-        matchCategory = other.matchCategory;
-        id = other.id;
-        text = other.text;
-        subtext = other.subtext;
-        icon = other.icon;
-        iconName = other.iconName;
-        data = other.data;
-        urls = other.urls;
-        actions = other.actions;
-        multiLine = other.multiLine;
+// Limits the number of icons, not their size. Icons sent by runners are small and usually reused across many matches and queries
+static constexpr int maxCachedIcons = 256;
+
+QIcon QueryMatchPrivate::resolveIcon() const
+{
+    if (!iconLoader) {
+        return icon;
     }
 
-    void setId(const QString &newId)
+    static QMutex mutex;
+    static QCache<QByteArray, QIcon> cache(maxCachedIcons);
     {
-        if (runner && runner->d->hasUniqueResults) {
-            id = newId;
-        } else {
-            if (runner) {
-                id = runner->id();
-            }
-            if (!id.isEmpty()) {
-                id.append(QLatin1Char('_')).append(newId);
-            }
+        QMutexLocker locker(&mutex);
+        if (const QIcon *cachedIcon = cache.object(iconKey)) {
+            return *cachedIcon;
         }
-        idSetByData = false;
     }
-
-    mutable QReadWriteLock lock;
-    QPointer<AbstractRunner> runner;
-    QString matchCategory;
-    QString id;
-    QString text;
-    QString subtext;
-    QString mimeType;
-    QList<QUrl> urls;
-    QIcon icon;
-    QString iconName;
-    QVariant data;
-    qreal categoryRelevance = 50;
-    qreal relevance = .7;
-    KRunner::Action selAction;
-    KRunner::Actions actions;
-    bool enabled = true;
-    bool idSetByData = false;
-    bool multiLine = false;
-};
+    // The icon is loaded without holding the mutex, in the worst case two threads decode it at the same time
+    const QIcon loadedIcon = iconLoader();
+    QMutexLocker locker(&mutex);
+    cache.insert(iconKey, new QIcon(loadedIcon));
+    return loadedIcon;
+}
 
 QueryMatch::QueryMatch(AbstractRunner *runner)
     : d(new QueryMatchPrivate(runner))
@@ -93,6 +75,8 @@ QueryMatch::QueryMatch(const QueryMatch &other)
 
     = default;
 
+QueryMatch::QueryMatch(QueryMatch &&other) noexcept = default;
+
 QueryMatch::~QueryMatch() = default;
 
 bool QueryMatch::isValid() const
@@ -111,7 +95,7 @@ QString QueryMatch::id() const
 
 void QueryMatch::setCategoryRelevance(qreal relevance)
 {
-    d->categoryRelevance = qBound(0.0, relevance, 100.0);
+    d->setCategoryRelevance(relevance);
 }
 
 qreal QueryMatch::categoryRelevance() const
@@ -121,7 +105,8 @@ qreal QueryMatch::categoryRelevance() const
 
 void QueryMatch::setMatchCategory(const QString &category)
 {
-    d->matchCategory = category;
+    QWriteLocker locker(d->writeLock());
+    d->setMatchCategory(category);
 }
 
 QString QueryMatch::matchCategory() const
@@ -134,7 +119,7 @@ QString QueryMatch::matchCategory() const
 
 void QueryMatch::setRelevance(qreal relevance)
 {
-    d->relevance = std::max(qreal(0.0), relevance);
+    d->setRelevance(relevance);
 }
 
 qreal QueryMatch::relevance() const
@@ -149,87 +134,109 @@ AbstractRunner *QueryMatch::runner() const
 
 void QueryMatch::setText(const QString &text)
 {
-    QWriteLocker locker(&d->lock);
+    QWriteLocker locker(d->writeLock());
     d->text = text;
 }
 
+void QueryMatch::setText(QString &&text)
+{
+    QWriteLocker locker(d->writeLock());
+    d->text = std::move(text);
+}
+
 void QueryMatch::setSubtext(const QString &subtext)
 {
-    QWriteLocker locker(&d->lock);
+    QWriteLocker locker(d->writeLock());
     d->subtext = subtext;
 }
 
+void QueryMatch::setSubtext(QString &&subtext)
+{
+    QWriteLocker locker(d->writeLock());
+    d->subtext = std::move(subtext);
+}
+
 void QueryMatch::setData(const QVariant &data)
 {
-    QWriteLocker locker(&d->lock);
-    d->data = data;
+    QWriteLocker locker(d->writeLock());
+    d->setData(data);
+}
 
-    if (d->id.isEmpty() || d->idSetByData) {
-        const QString matchId = data.toString();
-        if (!matchId.isEmpty()) {
-            d->setId(matchId);
-            d->idSetByData = true;
-        }
-    }
+void QueryMatch::setData(QVariant &&data)
+{
+    QWriteLocker locker(d->writeLock());
+    d->setData(std::move(data));
 }
 
 void QueryMatch::setId(const QString &id)
 {
-    QWriteLocker locker(&d->lock);
+    QWriteLocker locker(d->writeLock());
     d->setId(id);
 }
 
 void QueryMatch::setIcon(const QIcon &icon)
 {
-    QWriteLocker locker(&d->lock);
-    d->icon = icon;
+    QWriteLocker locker(d->writeLock());
+    d->setIcon(icon);
+}
+
+void QueryMatch::setIcon(QIcon &&icon)
+{
+    QWriteLocker locker(d->writeLock());
+    d->setIcon(std::move(icon));
 }
 
 void QueryMatch::setIconName(const QString &iconName)
 {
-    QWriteLocker locker(&d->lock);
+    QWriteLocker locker(d->writeLock());
     d->iconName = iconName;
 }
 
 QVariant QueryMatch::data() const
 {
-    QReadLocker locker(&d->lock);
+    QReadLocker locker(d->readLock());
     return d->data;
 }
 
 QString QueryMatch::text() const
 {
-    QReadLocker locker(&d->lock);
+    QReadLocker locker(d->readLock());
     return d->text;
 }
 
 QString QueryMatch::subtext() const
 {
-    QReadLocker locker(&d->lock);
+    QReadLocker locker(d->readLock());
     return d->subtext;
 }
 
 QIcon QueryMatch::icon() const
 {
-    QReadLocker locker(&d->lock);
-    return d->icon;
+    QReadLocker locker(d->readLock());
+    return d->resolveIcon();
 }
 
 QString QueryMatch::iconName() const
 {
-    QReadLocker locker(&d->lock);
+    QReadLocker locker(d->readLock());
     return d->iconName;
 }
 
 void QueryMatch::setUrls(const QList<QUrl> &urls)
 {
-    QWriteLocker locker(&d->lock);
+    QWriteLocker locker(d->writeLock());
     d->urls = urls;
 }
 
+void QueryMatch::setUrls(QList<QUrl> &&urls)
+{
+    QWriteLocker locker(d->writeLock());
+    d->urls = std::move(urls);
+}
+
 QList<QUrl> QueryMatch::urls() const
 {
-    QReadLocker locker(&d->lock);
+    QReadLocker locker(d->readLock());
     return d->urls;
 }
 
@@ -272,6 +279,8 @@ QueryMatch &QueryMatch::operator=(const QueryMatch &other)
     return *this;
 }
 
+QueryMatch &QueryMatch::operator=(QueryMatch &&other) noexcept = default;
+
 bool QueryMatch::operator==(const QueryMatch &other) const
 {
     return (d == other.d);
@@ -284,19 +293,25 @@ bool QueryMatch::operator!=(const QueryMatch &other) const
 
 void QueryMatch::setActions(const QList<KRunner::Action> &actions)
 {
-    QWriteLocker locker(&d->lock);
+    QWriteLocker locker(d->writeLock());
     d->actions = actions;
 }
 
+void QueryMatch::setActions(QList<KRunner::Action> &&actions)
+{
+    QWriteLocker locker(d->writeLock());
+    d->actions = std::move(actions);
+}
+
 void QueryMatch::addAction(const KRunner::Action &action)
 {
-    QWriteLocker locker(&d->lock);
+    QWriteLocker locker(d->writeLock());
     d->actions << action;
 }
 
 KRunner::Actions QueryMatch::actions() const
 {
-    QReadLocker locker(&d->lock);
+    QReadLocker locker(d->readLock());
     return d->actions;
 }
 
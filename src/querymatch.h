@@ -43,8 +43,19 @@ public:
 
     QueryMatch(const QueryMatch &other);
 
+    /*!
+     * Moves the data of \a other into a new match. The moved-from match may only be assigned to or destroyed.
+     *
+     * \since 6.29
+     */
+    QueryMatch(QueryMatch &&other) noexcept;
+
     ~QueryMatch();
     QueryMatch &operator=(const QueryMatch &other);
+    /*!
+     * \since 6.29
+     */
+    QueryMatch &operator=(QueryMatch &&other) noexcept;
     bool operator==(const QueryMatch &other) const;
     bool operator!=(const QueryMatch &other) const;
 
@@ -144,6 +155,12 @@ public:
      */
     void setData(const QVariant &data);
 
+    /*!
+     * \overload
+     * \since 6.29
+     */
+    void setData(QVariant &&data);
+
     /*!
      * Returns the data associated with this match; usually runner-specific
      */
@@ -186,6 +203,12 @@ public:
      */
     void setText(const QString &text);
 
+    /*!
+     * \overload
+     * \since 6.29
+     */
+    void setText(QString &&text);
+
     /*!
      * Returns the title text for this match
      */
@@ -199,6 +222,12 @@ public:
      */
     void setSubtext(const QString &text);
 
+    /*!
+     * \overload
+     * \since 6.29
+     */
+    void setSubtext(QString &&text);
+
     /*!
      * Returns the descriptive text for this match
      */
@@ -213,6 +242,12 @@ public:
      */
     void setIcon(const QIcon &icon);
 
+    /*!
+     * \overload
+     * \since 6.29
+     */
+    void setIcon(QIcon &&icon);
+
     /*!
      * Returns the icon for this match
      */
@@ -234,9 +269,19 @@ public:
 
     /*!
      * Sets the urls, if any, associated with this match
+     *
+     * If the "X-Plasma-Runner-Url-Deduplication-Priority" property from the metadata
+     * is set to a non-negative value, matches from different runners that point to the same
+     * url are deduplicated. Only the match of the runner with the highest priority is kept.
      */
     void setUrls(const QList<QUrl> &urls);
 
+    /*!
+     * \overload
+     * \since 6.29
+     */
+    void setUrls(QList<QUrl> &&urls);
+
     /*!
      * Returns the urls for this match, empty list if none
      * These will be used in the default implementation of AbstractRunner::mimeDataForMatch
@@ -263,6 +308,12 @@ public:
      */
     void setActions(const QList<KRunner::Action> &actions);
 
+    /*!
+     * \overload
+     * \since 6.29
+     */
+    void setActions(QList<KRunner::Action> &&actions);
+
     /*!
      * Adds an action to this match
      * \since 5.75
@@ -302,6 +353,7 @@ public:
 private:
     KRUNNER_NO_EXPORT void setSelectedAction(const KRunner::Action &action);
     friend class RunnerManager;
+    friend class QueryMatchBuilder;
     QSharedDataPointer<QueryMatchPrivate> d;
 };
 
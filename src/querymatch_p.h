@@ -0,0 +1,156 @@
+/*
+    SPDX-FileCopyrightText: 2006-2007 Aaron Seigo <aseigo@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QIcon>
+#include <QPointer>
+#include <QReadWriteLock>
+#include <QSharedData>
+#include <QVariant>
+
+#include <functional>
+
+#include "abstractrunner.h"
+#include "abstractrunner_p.h"
+#include "action.h"
+
+namespace KRunner
+{
+class QueryMatchPrivate : public QSharedData
+{
+public:
+    explicit QueryMatchPrivate(AbstractRunner *r)
+        : QSharedData()
+        , runner(r)
+    {
+    }
+
+    // A copy is only made when detaching before a modification, thus it is never frozen
+    QueryMatchPrivate(const QueryMatchPrivate &other)
+        : QSharedData(other)
+    {
+        QReadLocker l(other.readLock());
+        runner = other.runner;
+        categoryRelevance = other.categoryRelevance;
+        relevance = other.relevance;
+        selAction = other.selAction;
+        enabled = other.enabled;
+        idSetByData = other.idSetByData;
+        matchCategory = other.matchCategory;
+        id = other.id;
+        text = other.text;
+        subtext = other.subtext;
+        icon = other.icon;
+        iconKey = other.iconKey;
+        iconLoader = other.iconLoader;
+        iconName = other.iconName;
+        data = other.data;
+        urls = other.urls;
+        actions = other.actions;
+        multiLine = other.multiLine;
+    }
+
+    // Matches built using the QueryMatchBuilder are never modified afterwards and can be read without locking
+    QReadWriteLock *readLock() const
+    {
+        return frozen ? nullptr : &lock;
+    }
+
+    // The setters of QueryMatch may still modify a built match, from then on it needs locking again
+    QReadWriteLock *writeLock()
+    {
+        frozen = false;
+        return &lock;
+    }
+
+    void setId(const QString &newId)
+    {
+        if (runner && runner->d->hasUniqueResults) {
+            id = newId;
+        } else {
+            if (runner) {
+                id = runner->id();
+            }
+            if (!id.isEmpty()) {
+                id.append(QLatin1Char('_')).append(newId);
+            }
+        }
+        idSetByData = false;
+    }
+
+    void setData(QVariant newData)
+    {
+        data = std::move(newData);
+
+        if (id.isEmpty() || idSetByData) {
+            const QString matchId = data.toString();
+            if (!matchId.isEmpty()) {
+                setId(matchId);
+                idSetByData = true;
+            }
+        }
+    }
+
+    void setCategoryRelevance(qreal newRelevance)
+    {
+        categoryRelevance = qBound(0.0, newRelevance, 100.0);
+    }
+
+    void setRelevance(qreal newRelevance)
+    {
+        relevance = std::max(qreal(0.0), newRelevance);
+    }
+
+    void setMatchCategory(const QString &category)
+    {
+        matchCategory = internedCategory(category);
+    }
+
+    void setIcon(QIcon newIcon)
+    {
+        icon = std::move(newIcon);
+        iconKey.clear();
+        iconLoader = nullptr;
+    }
+
+    void setIconLoader(const QByteArray &key, const std::function<QIcon()> &loader)
+    {
+        icon = QIcon();
+        iconKey = key;
+        iconLoader = loader;
+    }
+
+    // Resolves icons set using setIconLoader, they are shared by all matches with the same key
+    QIcon resolveIcon() const;
+
+    // Returns a string that shares its data with all other matches of the same category
+    static QString internedCategory(const QString &category);
+
+    mutable QReadWriteLock lock;
+    QPointer<AbstractRunner> runner;
+    QString matchCategory;
+    QString id;
+    QString text;
+    QString subtext;
+    QString mimeType;
+    QList<QUrl> urls;
+    QIcon icon;
+    // Icons provided as raw data are only decoded once they are shown
+    QByteArray iconKey;
+    std::function<QIcon()> iconLoader;
+    QString iconName;
+    QVariant data;
+    qreal categoryRelevance = 50;
+    qreal relevance = .7;
+    KRunner::Action selAction;
+    KRunner::Actions actions;
+    bool enabled = true;
+    bool idSetByData = false;
+    bool multiLine = false;
+    bool frozen = false;
+};
+}
@@ -0,0 +1,105 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "querymatchbatch.h"
+#include "querymatchbatch_p.h"
+#include "querymatchbuilder.h"
+
+namespace KRunner
+{
+QueryMatchBatch::QueryMatchBatch(AbstractRunner *runner)
+    : d(new QueryMatchBatchPrivate(runner))
+{
+}
+
+QueryMatchBatch::QueryMatchBatch(const QueryMatchBatch &other) = default;
+QueryMatchBatch::QueryMatchBatch(QueryMatchBatch &&other) noexcept = default;
+QueryMatchBatch::~QueryMatchBatch() = default;
+QueryMatchBatch &QueryMatchBatch::operator=(const QueryMatchBatch &other) = default;
+QueryMatchBatch &QueryMatchBatch::operator=(QueryMatchBatch &&other) noexcept = default;
+
+AbstractRunner *QueryMatchBatch::runner() const
+{
+    return d->runner;
+}
+
+void QueryMatchBatch::setCategoryRelevance(QueryMatch::CategoryRelevance relevance)
+{
+    d->categoryRelevance = qToUnderlying(relevance);
+}
+
+void QueryMatchBatch::setMatchCategory(const QString &category)
+{
+    d->matchCategory = category;
+}
+
+void QueryMatchBatch::setActions(const QList<KRunner::Action> &actions)
+{
+    d->actions = actions;
+}
+
+void QueryMatchBatch::setMultiLine(bool multiLine)
+{
+    d->multiLine = multiLine;
+}
+
+void QueryMatchBatch::reserve(qsizetype size)
+{
+    d->ids.reserve(size);
+    d->texts.reserve(size);
+    d->subtexts.reserve(size);
+    d->iconNames.reserve(size);
+    d->relevances.reserve(size);
+    d->urls.reserve(size);
+}
+
+void QueryMatchBatch::addMatch(const QString &id, const QString &text, const QString &subtext, const QString &iconName, qreal relevance, const QList<QUrl> &urls)
+{
+    d->ids.append(id);
+    d->texts.append(text);
+    d->subtexts.append(subtext);
+    d->iconNames.append(iconName);
+    d->relevances.append(std::max(qreal(0.0), relevance));
+    d->urls.append(urls);
+}
+
+qsizetype QueryMatchBatch::size() const
+{
+    return d->ids.size();
+}
+
+bool QueryMatchBatch::isEmpty() const
+{
+    return d->ids.isEmpty();
+}
+
+QueryMatch QueryMatchBatch::match(qsizetype index) const
+{
+    Q_ASSERT(index >= 0 && index < size());
+    return QueryMatchBuilder(d->runner)
+        .setId(d->ids.at(index))
+        .setText(d->texts.at(index))
+        .setSubtext(d->subtexts.at(index))
+        .setIconName(d->iconNames.at(index))
+        .setRelevance(d->relevances.at(index))
+        .setUrls(d->urls.at(index))
+        .setMatchCategory(d->matchCategory)
+        .setCategoryRelevance(d->categoryRelevance)
+        .setActions(d->actions)
+        .setMultiLine(d->multiLine)
+        .build();
+}
+
+QList<QueryMatch> QueryMatchBatch::matches() const
+{
+    QList<QueryMatch> matches;
+    matches.reserve(size());
+    for (qsizetype i = 0; i < size(); ++i) {
+        matches.append(match(i));
+    }
+    return matches;
+}
+}
@@ -0,0 +1,144 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KRUNNER_QUERYMATCHBATCH_H
+#define KRUNNER_QUERYMATCHBATCH_H
+
+#include <QList>
+#include <QSharedDataPointer>
+#include <QUrl>
+
+#include "krunner_export.h"
+#include "querymatch.h"
+
+namespace KRunner
+{
+class AbstractRunner;
+class QueryMatchBatchPrivate;
+
+/*!
+ * \class KRunner::QueryMatchBatch
+ * \inheaderfile KRunner/QueryMatchBatch
+ * \inmodule KRunner
+ *
+ * \brief Collects many uniform matches of one runner in a compact form.
+ *
+ * Runners that produce a lot of similar matches per query, like file or contact searches,
+ * can add them to a batch instead of creating a QueryMatch for each of them.
+ * The per-match values are stored in contiguous lists, the remaining properties are shared by all matches of the batch.
+ *
+ * When the batch is passed to RunnerContext::addMatches, a QueryMatch is only created for
+ * matches that are not dropped because of their id, their urls or the runner's maximum number of results.
+ *
+ * \code
+ * QueryMatchBatch batch(this);
+ * batch.setMatchCategory(i18n("Files"));
+ * batch.reserve(files.size());
+ * for (const File &file : files) {
+ *     batch.addMatch(file.path, file.name, file.directory, file.iconName, file.score, {QUrl::fromLocalFile(file.path)});
+ * }
+ * context.addMatches(batch);
+ * \endcode
+ *
+ * \since 6.29
+ */
+class KRUNNER_EXPORT QueryMatchBatch
+{
+public:
+    /*!
+     * Creates an empty batch for matches of the given \a runner
+     */
+    explicit QueryMatchBatch(AbstractRunner *runner);
+    QueryMatchBatch(const QueryMatchBatch &other);
+    QueryMatchBatch(QueryMatchBatch &&other) noexcept;
+    ~QueryMatchBatch();
+    QueryMatchBatch &operator=(const QueryMatchBatch &other);
+    QueryMatchBatch &operator=(QueryMatchBatch &&other) noexcept;
+
+    /*!
+     * Returns the runner the matches belong to
+     */
+    AbstractRunner *runner() const;
+
+    /*!
+     * Sets the category relevance of all matches
+     * \sa QueryMatch::setCategoryRelevance
+     */
+    void setCategoryRelevance(QueryMatch::CategoryRelevance relevance);
+
+    /*!
+     * Sets the category of all matches
+     * \sa QueryMatch::setMatchCategory
+     */
+    void setMatchCategory(const QString &category);
+
+    /*!
+     * Sets the actions of all matches
+     * \sa QueryMatch::setActions
+     */
+    void setActions(const QList<KRunner::Action> &actions);
+
+    /*!
+     * Sets whether the text of all matches should be displayed as a multiLine string
+     * \sa QueryMatch::setMultiLine
+     */
+    void setMultiLine(bool multiLine);
+
+    /*!
+     * Reserves space for \a size matches
+     */
+    void reserve(qsizetype size);
+
+    /*!
+     * Appends a match to the batch
+     *
+     * \a id the id of the match, see QueryMatch::setId
+     *
+     * \a text the title text, see QueryMatch::setText
+     *
+     * \a subtext the descriptive text, see QueryMatch::setSubtext
+     *
+     * \a iconName the name of the icon, see QueryMatch::setIconName
+     *
+     * \a relevance the relevance of the match, see QueryMatch::setRelevance
+     *
+     * \a urls the urls of the match, see QueryMatch::setUrls
+     */
+    void addMatch(const QString &id,
+                  const QString &text,
+                  const QString &subtext,
+                  const QString &iconName,
+                  qreal relevance,
+                  const QList<QUrl> &urls = QList<QUrl>());
+
+    /*!
+     * Returns the number of matches in the batch
+     */
+    qsizetype size() const;
+
+    /*!
+     * Returns true if the batch contains no matches
+     */
+    bool isEmpty() const;
+
+    /*!
+     * Creates the match at the given \a index
+     */
+    QueryMatch match(qsizetype index) const;
+
+    /*!
+     * Creates all matches of the batch
+     *
+     * Prefer passing the batch to RunnerContext::addMatches, which only creates the matches that are kept
+     */
+    QList<QueryMatch> matches() const;
+
+private:
+    friend class RunnerContextPrivate;
+    QSharedDataPointer<QueryMatchBatchPrivate> d;
+};
+}
+#endif
@@ -0,0 +1,40 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QPointer>
+#include <QSharedData>
+
+#include "abstractrunner.h"
+#include "action.h"
+#include "querymatch.h"
+
+namespace KRunner
+{
+class QueryMatchBatchPrivate : public QSharedData
+{
+public:
+    explicit QueryMatchBatchPrivate(AbstractRunner *r)
+        : runner(r)
+    {
+    }
+
+    QPointer<AbstractRunner> runner;
+    QString matchCategory;
+    KRunner::Actions actions;
+    qreal categoryRelevance = qToUnderlying(QueryMatch::CategoryRelevance::Moderate);
+    bool multiLine = false;
+
+    // One entry per match
+    QStringList ids;
+    QStringList texts;
+    QStringList subtexts;
+    QStringList iconNames;
+    QList<qreal> relevances;
+    QList<QList<QUrl>> urls;
+};
+}
@@ -0,0 +1,152 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "querymatchbuilder.h"
+#include "querymatch_p.h"
+
+namespace KRunner
+{
+// The builder is the only one referencing the private until build() is called, thus no locking is needed
+QueryMatchBuilder::QueryMatchBuilder(AbstractRunner *runner)
+    : m_match(runner)
+{
+}
+
+QueryMatchBuilder::~QueryMatchBuilder() = default;
+
+QueryMatchBuilder &QueryMatchBuilder::setCategoryRelevance(qreal relevance)
+{
+    m_match.d->setCategoryRelevance(relevance);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setMatchCategory(const QString &category)
+{
+    m_match.d->setMatchCategory(category);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setRelevance(qreal relevance)
+{
+    m_match.d->setRelevance(relevance);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setData(const QVariant &data)
+{
+    m_match.d->setData(data);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setData(QVariant &&data)
+{
+    m_match.d->setData(std::move(data));
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setId(const QString &id)
+{
+    m_match.d->setId(id);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setText(const QString &text)
+{
+    m_match.d->text = text;
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setText(QString &&text)
+{
+    m_match.d->text = std::move(text);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setSubtext(const QString &text)
+{
+    m_match.d->subtext = text;
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setSubtext(QString &&text)
+{
+    m_match.d->subtext = std::move(text);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setIcon(const QIcon &icon)
+{
+    m_match.d->setIcon(icon);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setIcon(QIcon &&icon)
+{
+    m_match.d->setIcon(std::move(icon));
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setIconLoader(const QByteArray &key, const std::function<QIcon()> &loader)
+{
+    m_match.d->setIconLoader(key, loader);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setIconName(const QString &iconName)
+{
+    m_match.d->iconName = iconName;
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setUrls(const QList<QUrl> &urls)
+{
+    m_match.d->urls = urls;
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setUrls(QList<QUrl> &&urls)
+{
+    m_match.d->urls = std::move(urls);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setEnabled(bool enable)
+{
+    m_match.d->enabled = enable;
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setActions(const QList<KRunner::Action> &actions)
+{
+    m_match.d->actions = actions;
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setActions(QList<KRunner::Action> &&actions)
+{
+    m_match.d->actions = std::move(actions);
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::addAction(const KRunner::Action &action)
+{
+    m_match.d->actions << action;
+    return *this;
+}
+
+QueryMatchBuilder &QueryMatchBuilder::setMultiLine(bool multiLine)
+{
+    m_match.d->multiLine = multiLine;
+    return *this;
+}
+
+QueryMatch QueryMatchBuilder::build()
+{
+    // Modifying the builder afterwards detaches, which creates a private that is not frozen
+    m_match.d->frozen = true;
+    return m_match;
+}
+}
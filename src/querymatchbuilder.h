@@ -0,0 +1,165 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KRUNNER_QUERYMATCHBUILDER_H
+#define KRUNNER_QUERYMATCHBUILDER_H
+
+#include "krunner_export.h"
+
+#include "querymatch.h"
+
+#include <functional>
+
+namespace KRunner
+{
+/*!
+ * \class KRunner::QueryMatchBuilder
+ * \inheaderfile KRunner/QueryMatchBuilder
+ * \inmodule KRunner
+ *
+ * \brief Constructs immutable QueryMatch instances.
+ *
+ * Matches are usually created once inside of AbstractRunner::match and only read afterwards.
+ * A match returned by build() is frozen, meaning reading its properties does not require any locking.
+ * Calling one of the QueryMatch setters on it is still possible, but unfreezes the match again.
+ *
+ * \code
+ * context.addMatch(QueryMatchBuilder(this).setId(id).setText(text).setRelevance(0.8).build());
+ * \endcode
+ *
+ * \since 6.29
+ */
+class KRUNNER_EXPORT QueryMatchBuilder
+{
+public:
+    /*!
+     * Creates a builder for a match belonging to the given \a runner
+     */
+    explicit QueryMatchBuilder(AbstractRunner *runner = nullptr);
+    ~QueryMatchBuilder();
+
+    /*!
+     * \sa QueryMatch::setCategoryRelevance
+     */
+    QueryMatchBuilder &setCategoryRelevance(QueryMatch::CategoryRelevance relevance)
+    {
+        return setCategoryRelevance(qToUnderlying(relevance));
+    }
+
+    /*!
+     * \internal Internal for now, consumers should utilize CategoryRelevance enum
+     */
+    QueryMatchBuilder &setCategoryRelevance(qreal relevance);
+
+    /*!
+     * \sa QueryMatch::setMatchCategory
+     */
+    QueryMatchBuilder &setMatchCategory(const QString &category);
+
+    /*!
+     * \sa QueryMatch::setRelevance
+     */
+    QueryMatchBuilder &setRelevance(qreal relevance);
+
+    /*!
+     * \sa QueryMatch::setData
+     */
+    QueryMatchBuilder &setData(const QVariant &data);
+
+    /*!
+     * \overload
+     */
+    QueryMatchBuilder &setData(QVariant &&data);
+
+    /*!
+     * \sa QueryMatch::setId
+     */
+    QueryMatchBuilder &setId(const QString &id);
+
+    /*!
+     * \sa QueryMatch::setText
+     */
+    QueryMatchBuilder &setText(const QString &text);
+
+    /*!
+     * \overload
+     */
+    QueryMatchBuilder &setText(QString &&text);
+
+    /*!
+     * \sa QueryMatch::setSubtext
+     */
+    QueryMatchBuilder &setSubtext(const QString &text);
+
+    /*!
+     * \overload
+     */
+    QueryMatchBuilder &setSubtext(QString &&text);
+
+    /*!
+     * \sa QueryMatch::setIcon
+     */
+    QueryMatchBuilder &setIcon(const QIcon &icon);
+
+    /*!
+     * \overload
+     */
+    QueryMatchBuilder &setIcon(QIcon &&icon);
+
+    /*!
+     * \sa QueryMatch::setIconName
+     */
+    QueryMatchBuilder &setIconName(const QString &iconName);
+
+    /*!
+     * \sa QueryMatch::setUrls
+     */
+    QueryMatchBuilder &setUrls(const QList<QUrl> &urls);
+
+    /*!
+     * \overload
+     */
+    QueryMatchBuilder &setUrls(QList<QUrl> &&urls);
+
+    /*!
+     * \sa QueryMatch::setEnabled
+     */
+    QueryMatchBuilder &setEnabled(bool enable);
+
+    /*!
+     * \sa QueryMatch::setActions
+     */
+    QueryMatchBuilder &setActions(const QList<KRunner::Action> &actions);
+
+    /*!
+     * \overload
+     */
+    QueryMatchBuilder &setActions(QList<KRunner::Action> &&actions);
+
+    /*!
+     * \sa QueryMatch::addAction
+     */
+    QueryMatchBuilder &addAction(const KRunner::Action &action);
+
+    /*!
+     * \sa QueryMatch::setMultiLine
+     */
+    QueryMatchBuilder &setMultiLine(bool multiLine);
+
+    /*!
+     * Returns the frozen match. The builder may be modified further to create
+     * more matches, which does not affect the ones that were already built.
+     */
+    QueryMatch build();
+
+private:
+    // Used by the DBusRunner to decode icon data only once the icon is shown, the icon is shared by all matches with the same key
+    KRUNNER_NO_EXPORT QueryMatchBuilder &setIconLoader(const QByteArray &key, const std::function<QIcon()> &loader);
+    friend class DBusRunner;
+    QueryMatch m_match;
+};
+}
+#endif
@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "remoteimage_p.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+#include "krunner_debug.h"
+
+namespace KRunner
+{
+QImage decodeRemoteImage(const RemoteImage &remoteImage)
+{
+    if (remoteImage.width <= 0 || remoteImage.width >= 2048 || remoteImage.height <= 0 || remoteImage.height >= 2048 || remoteImage.rowStride <= 0) {
+        qCWarning(KRUNNER) << "Invalid image metadata (width:" << remoteImage.width << "height:" << remoteImage.height << "rowStride:" << remoteImage.rowStride
+                           << ")";
+        return {};
+    }
+
+    // The pixel data is wrapped as-is, QImage's conversion routines take care of the (vectorized) conversion to a format we can paint
+    QImage::Format format = QImage::Format_Invalid;
+    if (remoteImage.bitsPerSample == 8) {
+        if (remoteImage.channels == 4) {
+            format = remoteImage.hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888;
+        } else if (remoteImage.channels == 3) {
+            format = QImage::Format_RGB888;
+        }
+    } else if (remoteImage.bitsPerSample == 16 && remoteImage.channels == 4 && remoteImage.rowStride % 2 == 0) {
+        format = remoteImage.hasAlpha ? QImage::Format_RGBA64 : QImage::Format_RGBX64;
+    }
+    if (format == QImage::Format_Invalid) {
+        qCWarning(KRUNNER) << "Unsupported image format (hasAlpha:" << remoteImage.hasAlpha << "bitsPerSample:" << remoteImage.bitsPerSample
+                           << "channels:" << remoteImage.channels << ")";
+        return {};
+    }
+
+    const qsizetype lineLength = qsizetype(remoteImage.width) * remoteImage.channels * remoteImage.bitsPerSample / 8;
+    if (remoteImage.rowStride < lineLength) {
+        qCWarning(KRUNNER) << "Invalid image metadata (width:" << remoteImage.width << "rowStride:" << remoteImage.rowStride << ")";
+        return {};
+    }
+    QByteArray pixels = remoteImage.data;
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    // 16 bit samples are sent in little endian byte order, QImage expects them in the one of the host
+    if (remoteImage.bitsPerSample == 16) {
+        QByteArray swapped(pixels.size() & ~1, Qt::Uninitialized);
+        qFromLittleEndian<quint16>(pixels.constData(), swapped.size() / 2, swapped.data());
+        pixels = swapped;
+    }
+#endif
+    int completeLines = 0;
+    if (pixels.size() >= lineLength) {
+        completeLines = std::min<qsizetype>(remoteImage.height, (pixels.size() - lineLength) / remoteImage.rowStride + 1);
+    }
+    if (Q_UNLIKELY(completeLines < remoteImage.height)) {
+        qCWarning(KRUNNER) << "Image data is incomplete. y:" << completeLines << "height:" << remoteImage.height;
+    }
+
+    const QImage::Format targetFormat = remoteImage.channels == 4 && remoteImage.hasAlpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    if (completeLines == remoteImage.height) {
+        const QImage wrapped(reinterpret_cast<const uchar *>(pixels.constData()), remoteImage.width, remoteImage.height, remoteImage.rowStride, format);
+        return wrapped.convertToFormat(targetFormat);
+    }
+
+    // Keep the lines we got, the missing ones stay transparent
+    QImage image(remoteImage.width, remoteImage.height, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    if (completeLines > 0) {
+        const QImage wrapped(reinterpret_cast<const uchar *>(pixels.constData()), remoteImage.width, completeLines, remoteImage.rowStride, format);
+        const QImage converted = wrapped.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        for (int y = 0; y < completeLines; ++y) {
+            memcpy(image.scanLine(y), converted.constScanLine(y), converted.bytesPerLine());
+        }
+    }
+    return image;
+}
+}
@@ -0,0 +1,18 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QImage>
+
+#include "dbusutils_p.h"
+
+namespace KRunner
+{
+// Converts the pixels of icon-data or of an icon shared using GetIcons to an image that can be painted.
+// Incomplete data results in an image whose missing lines are transparent, invalid data in a null image
+QImage decodeRemoteImage(const RemoteImage &remoteImage);
+}
@@ -7,7 +7,11 @@
 
 #include "runnercontext.h"
 
+#include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <memory>
+#include <numeric>
 
 #include <QPointer>
 #include <QReadWriteLock>
@@ -21,22 +25,30 @@
 #include "abstractrunner.h"
 #include "abstractrunner_p.h"
 #include "querymatch.h"
+#include "querymatchbatch.h"
+#include "querymatchbatch_p.h"
 #include "runnermanager.h"
 
 namespace KRunner
 {
+class RunnerContextPrivate;
+// Privates of previous queries, they get reused once no runner references them anymore
+using RunnerContextPool = QList<QExplicitlySharedDataPointer<RunnerContextPrivate>>;
+
 class RunnerContextPrivate : public QSharedData
 {
 public:
     explicit RunnerContextPrivate(RunnerManager *manager)
         : QSharedData()
         , m_manager(manager)
+        , pool(std::make_shared<RunnerContextPool>())
     {
     }
 
     RunnerContextPrivate(const RunnerContextPrivate &p)
         : QSharedData(p)
         , m_manager(p.m_manager)
+        , pool(p.pool)
     {
     }
 
@@ -47,25 +59,303 @@ public:
         m_isValid = false;
     }
 
-    void addMatch(const QueryMatch &match)
+    // Unlike clear(), this keeps the allocated buckets for the next query
+    template<typename Hash>
+    static void eraseAll(Hash &hash)
+    {
+        for (auto it = hash.begin(); it != hash.end();) {
+            it = hash.erase(it);
+        }
+    }
+
+    // Hands this invalidated private over to the pool and returns the one that should be used for the next query.
+    // This avoids allocating a new private including its containers on every keystroke.
+    QExplicitlySharedDataPointer<RunnerContextPrivate> recycle()
+    {
+        const std::shared_ptr<RunnerContextPool> sharedPool = pool;
+        QExplicitlySharedDataPointer<RunnerContextPrivate> next;
+        for (auto it = sharedPool->begin(); it != sharedPool->end(); ++it) {
+            // Only the pool references it, meaning all runners are done with the old query
+            if ((*it)->ref.loadAcquire() == 1) {
+                next = *it;
+                sharedPool->erase(it);
+                break;
+            }
+        }
+
+        if (next) {
+            next->m_manager = m_manager;
+            next->pool = sharedPool;
+            next->requestedText.clear();
+            next->requestedCursorPosition = 0;
+            next->queryStartTs = 0;
+        } else {
+            next.reset(new RunnerContextPrivate(*this));
+        }
+
+        if (sharedPool->size() < maxPoolSize) {
+            QWriteLocker locker(&lock);
+            // Runners can not add matches anymore, so we can get rid of the old ones right away
+            matches.clear();
+            sortedCount = 0;
+            eraseAll(uniqueIds);
+            eraseAll(urlMatches);
+            pool.reset(); // The pool must not own itself
+            sharedPool->append(QExplicitlySharedDataPointer<RunnerContextPrivate>(this));
+        }
+        return next;
+    }
+
+    static bool isMoreRelevant(const QueryMatch &a, const QueryMatch &b)
+    {
+        if (a.categoryRelevance() != b.categoryRelevance()) {
+            return a.categoryRelevance() > b.categoryRelevance();
+        }
+        return a.relevance() > b.relevance();
+    }
+
+    // The matches are kept ordered by their category relevance and relevance. New ones are appended
+    // and then merged into the already sorted range, which is linear instead of resorting everything
+    void addMatches(const QList<QueryMatch> &newMatches)
+    {
+        auto remainingResults = maxResultsOf(newMatches);
+        sortedCount = matches.size();
+        for (const QueryMatch &match : newMatches) {
+            addMatch(QueryMatch(match));
+        }
+        mergeNewMatches(remainingResults);
+    }
+
+    void addMatches(QList<QueryMatch> &&newMatches)
+    {
+        auto remainingResults = maxResultsOf(newMatches);
+        sortedCount = matches.size();
+        for (QueryMatch &match : newMatches) {
+            addMatch(std::move(match));
+        }
+        mergeNewMatches(remainingResults);
+    }
+
+    // Only creates matches for the entries of the batch that can end up in the results. The entries are visited starting with
+    // the most relevant one, those dropped because of their id or urls are skipped before a match is created for them.
+    // Once the runner contributed its maximum number of results, or the entries cannot outrank its kept matches anymore, the rest is skipped
+    void addMatches(const QueryMatchBatch &batch)
+    {
+        const QueryMatchBatchPrivate *batchData = batch.d.constData();
+        const AbstractRunner *runner = batchData->runner;
+        const int maxResults = runner ? runner->d->currentMaxResults() : 0;
+
+        QList<qsizetype> indices(batch.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        QHash<const AbstractRunner *, int> remainingResults;
+        // Lowest ranked match of the runner that survives its maximum number of results
+        QueryMatch lastKeptMatch;
+        if (maxResults > 0) {
+            std::stable_sort(indices.begin(), indices.end(), [batchData](qsizetype a, qsizetype b) {
+                return batchData->relevances.at(a) > batchData->relevances.at(b);
+            });
+            remainingResults.insert(runner, maxResults);
+            // Replacing weak results removes matches of the runner itself, then the kept matches change
+            if (!runner->d->hasWeakResults) {
+                int keptCount = 0;
+                for (const QueryMatch &match : std::as_const(matches)) {
+                    if (match.runner() == runner && ++keptCount == maxResults) {
+                        lastKeptMatch = match;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // On equal relevance the existing match stays in front when merging
+        const auto outranksLastKeptMatch = [batchData, &lastKeptMatch](qsizetype index) {
+            if (batchData->categoryRelevance != lastKeptMatch.categoryRelevance()) {
+                return batchData->categoryRelevance > lastKeptMatch.categoryRelevance();
+            }
+            return batchData->relevances.at(index) > lastKeptMatch.relevance();
+        };
+
+        sortedCount = matches.size();
+        int addedCount = 0;
+        for (qsizetype index : std::as_const(indices)) {
+            if (maxResults > 0 && (addedCount == maxResults || (lastKeptMatch.runner() && !outranksLastKeptMatch(index)))) {
+                break;
+            }
+            if (isDuplicateId(runner, batchData->ids.at(index)) || hasSuperiorUrlMatch(runner, batchData->urls.at(index))) {
+                continue;
+            }
+            if (addMatch(batch.match(index))) {
+                ++addedCount;
+            }
+        }
+        mergeNewMatches(remainingResults);
+    }
+
+    void mergeNewMatches(QHash<const AbstractRunner *, int> &remainingResults)
+    {
+        const auto sortedEnd = matches.begin() + sortedCount;
+        std::stable_sort(sortedEnd, matches.end(), isMoreRelevant);
+        std::inplace_merge(matches.begin(), sortedEnd, matches.end(), isMoreRelevant);
+        enforceMaxResults(remainingResults);
+        sortedCount = matches.size();
+    }
+
+    // Runners may limit how many matches they contribute using X-Plasma-Runner-Max-Results or the MaxResults config entry
+    static QHash<const AbstractRunner *, int> maxResultsOf(const QList<QueryMatch> &newMatches)
+    {
+        QHash<const AbstractRunner *, int> remainingResults;
+        // The matches added at once usually come from a single runner, that avoids locking it for every match
+        const AbstractRunner *previousRunner = nullptr;
+        for (const QueryMatch &match : newMatches) {
+            const AbstractRunner *runner = match.runner();
+            if (!runner || runner == previousRunner) {
+                continue;
+            }
+            previousRunner = runner;
+            if (const int maxResults = runner->d->currentMaxResults(); maxResults > 0) {
+                remainingResults.insert(runner, maxResults);
+            }
+        }
+        return remainingResults;
+    }
+
+    // Because the matches are sorted, the first ones of each runner are the most relevant ones and everything after that is dropped
+    void enforceMaxResults(QHash<const AbstractRunner *, int> &remainingResults)
+    {
+        if (remainingResults.isEmpty()) {
+            return;
+        }
+
+        matches.removeIf([this, &remainingResults](const QueryMatch &match) {
+            const auto it = remainingResults.find(match.runner());
+            if (it == remainingResults.end()) {
+                return false;
+            }
+            if (it.value() > 0) {
+                --it.value();
+                return false;
+            }
+            forgetMatch(match);
+            return true;
+        });
+    }
+
+    // Returns false if the match was dropped as a duplicate
+    bool addMatch(QueryMatch &&match)
     {
         if (match.runner() && match.runner()->d->hasUniqueResults) {
-            if (uniqueIds.contains(match.id())) {
-                const QueryMatch &existentMatch = uniqueIds.value(match.id());
-                if (existentMatch.runner() && existentMatch.runner()->d->hasWeakResults) {
-                    // There is an existing match with the same ID and we are allowed to replace it
-                    matches.removeOne(existentMatch);
-                    matches.append(match);
+            const QString id = match.id();
+            QueryMatch weakMatch;
+            bool replacesWeakMatch = false;
+            if (const auto it = uniqueIds.constFind(id); it != uniqueIds.cend()) {
+                if (!it->runner() || !it->runner()->d->hasWeakResults) {
+                    return false;
                 }
-            } else {
-                // There is no existing match with the same id
-                uniqueIds.insert(match.id(), match);
-                matches.append(match);
+                weakMatch = it.value();
+                replacesWeakMatch = true;
             }
-        } else {
+            // The weak match is only replaced if the new one is not dropped because of its urls, otherwise both would be gone
+            if (!resolveUrlDuplicates(match)) {
+                return false;
+            }
+            if (replacesWeakMatch) {
+                removeMatch(weakMatch);
+            }
+            uniqueIds.insert(id, match);
+            matches.append(std::move(match));
+            return true;
+        } else if (resolveUrlDuplicates(match)) {
             // Runner has the unique results property not set
-            matches.append(match);
+            matches.append(std::move(match));
+            return true;
         }
+        return false;
+    }
+
+    // Whether a match with the given id would be dropped because the runner has unique results and the id is already taken
+    bool isDuplicateId(const AbstractRunner *runner, const QString &id) const
+    {
+        if (!runner || !runner->d->hasUniqueResults) {
+            return false;
+        }
+        const auto it = uniqueIds.constFind(id);
+        return it != uniqueIds.cend() && !(it->runner() && it->runner()->d->hasWeakResults);
+    }
+
+    void removeMatch(const QueryMatch &match)
+    {
+        if (const qsizetype index = matches.indexOf(match); index != -1) {
+            matches.removeAt(index);
+            if (index < sortedCount) {
+                --sortedCount;
+            }
+        }
+        forgetMatch(match);
+    }
+
+    // Removes the match from the lookup tables used for deduplication
+    void forgetMatch(const QueryMatch &match)
+    {
+        if (const auto it = uniqueIds.constFind(match.id()); it != uniqueIds.cend() && it.value() == match) {
+            uniqueIds.erase(it);
+        }
+        const QList<QUrl> urls = match.urls();
+        for (const QUrl &url : urls) {
+            urlMatches.remove(normalizedUrl(url), match);
+        }
+    }
+
+    // Whether another runner with at least the same X-Plasma-Runner-Url-Deduplication-Priority already has a match for one of the urls
+    bool hasSuperiorUrlMatch(const AbstractRunner *runner, const QList<QUrl> &urls) const
+    {
+        if (!runner || runner->d->urlDeduplicationPriority < 0) {
+            return false;
+        }
+        const int priority = runner->d->urlDeduplicationPriority;
+        return std::any_of(urls.cbegin(), urls.cend(), [this, runner, priority](const QUrl &url) {
+            const auto [begin, end] = urlMatches.equal_range(normalizedUrl(url));
+            return std::any_of(begin, end, [runner, priority](const QueryMatch &match) {
+                return match.runner() != runner && match.runner() && match.runner()->d->urlDeduplicationPriority >= priority;
+            });
+        });
+    }
+
+    static QUrl normalizedUrl(const QUrl &url)
+    {
+        return url.adjusted(QUrl::NormalizePathSegments | QUrl::StripTrailingSlash);
+    }
+
+    // Different runners may point to the same target, in that case only the match of the runner with the highest
+    // X-Plasma-Runner-Url-Deduplication-Priority is kept. Returns false if the match should be dropped
+    bool resolveUrlDuplicates(const QueryMatch &match)
+    {
+        const AbstractRunner *runner = match.runner();
+        if (!runner || runner->d->urlDeduplicationPriority < 0) {
+            return true;
+        }
+        const QList<QUrl> urls = match.urls();
+        if (urls.isEmpty()) {
+            return true;
+        }
+
+        if (hasSuperiorUrlMatch(runner, urls)) {
+            return false;
+        }
+        QList<QueryMatch> inferiorMatches;
+        for (const QUrl &url : urls) {
+            const auto [begin, end] = urlMatches.equal_range(normalizedUrl(url));
+            std::copy_if(begin, end, std::back_inserter(inferiorMatches), [runner](const QueryMatch &match) {
+                return match.runner() != runner;
+            });
+        }
+
+        for (const QueryMatch &inferiorMatch : std::as_const(inferiorMatches)) {
+            removeMatch(inferiorMatch);
+        }
+        for (const QUrl &url : urls) {
+            urlMatches.insert(normalizedUrl(url), match);
+        }
+        return true;
     }
 
     void matchesChanged()
@@ -79,13 +369,19 @@ public:
     QPointer<RunnerManager> m_manager;
     bool m_isValid = true;
     QList<QueryMatch> matches;
+    // Number of matches at the front that are already sorted, only differs from the size while adding matches
+    qsizetype sortedCount = 0;
     QString term;
     bool singleRunnerQueryMode = false;
     bool shouldIgnoreCurrentMatchForHistory = false;
     QHash<QString, QueryMatch> uniqueIds;
+    // All matches pointing to a url, a runner may have several matches for the same one
+    QMultiHash<QUrl, QueryMatch> urlMatches;
     QString requestedText;
     int requestedCursorPosition = 0;
     qint64 queryStartTs = 0;
+    std::shared_ptr<RunnerContextPool> pool;
+    static constexpr qsizetype maxPoolSize = 3;
 };
 
 RunnerContext::RunnerContext(RunnerManager *manager)
@@ -135,18 +431,23 @@ void RunnerContext::reset()
         d->invalidate();
     }
 
-    d.detach();
-    // But out detached version is valid!
+    if (d->ref.loadAcquire() != 1) {
+        // Copies used by runners keep the invalidated private, we continue with a recycled one
+        d = d->recycle();
+    }
+    // But our new version is valid!
     d->m_isValid = true;
 
     // we still have to remove all the matches, since if the
     // ref count was 1 (e.g. only the RunnerContext is using
     // the dptr) then we won't get a copy made
     d->matches.clear();
+    d->sortedCount = 0;
     d->term.clear();
     d->matchesChanged();
 
-    d->uniqueIds.clear();
+    RunnerContextPrivate::eraseAll(d->uniqueIds);
+    RunnerContextPrivate::eraseAll(d->urlMatches);
     d->singleRunnerQueryMode = false;
     d->shouldIgnoreCurrentMatchForHistory = false;
 }
@@ -188,9 +489,38 @@ bool RunnerContext::addMatches(const QList<QueryMatch> &matches)
 
     {
         QWriteLocker locker(&d->lock);
-        for (const QueryMatch &match : matches) {
-            d->addMatch(match);
-        }
+        d->addMatches(matches);
+    }
+    d->matchesChanged();
+
+    return true;
+}
+
+bool RunnerContext::addMatches(QList<QueryMatch> &&matches)
+{
+    if (matches.isEmpty() || !isValid()) {
+        // Bail out if the query is empty or the qptr is dirty
+        return false;
+    }
+
+    {
+        QWriteLocker locker(&d->lock);
+        d->addMatches(std::move(matches));
+    }
+    d->matchesChanged();
+
+    return true;
+}
+
+bool RunnerContext::addMatches(const QueryMatchBatch &batch)
+{
+    if (batch.isEmpty() || !isValid()) {
+        return false;
+    }
+
+    {
+        QWriteLocker locker(&d->lock);
+        d->addMatches(batch);
     }
     d->matchesChanged();
 
@@ -199,7 +529,14 @@ bool RunnerContext::addMatches(const QList<QueryMatch> &matches)
 
 bool RunnerContext::addMatch(const QueryMatch &match)
 {
-    return addMatches({match});
+    return addMatch(QueryMatch(match));
+}
+
+bool RunnerContext::addMatch(QueryMatch &&match)
+{
+    QList<QueryMatch> matches;
+    matches.append(std::move(match));
+    return addMatches(std::move(matches));
 }
 
 QList<QueryMatch> RunnerContext::matches() const
@@ -19,6 +19,7 @@ namespace KRunner
 {
 class RunnerManager;
 class QueryMatch;
+class QueryMatchBatch;
 class AbstractRunner;
 class RunnerContextPrivate;
 
@@ -73,6 +74,26 @@ public:
      */
     bool addMatches(const QList<QueryMatch> &matches);
 
+    /*!
+     * \overload
+     *
+     * Moves the matches into the context instead of copying them.
+     *
+     * \since 6.29
+     */
+    bool addMatches(QList<QueryMatch> &&matches);
+
+    /*!
+     * \overload
+     *
+     * Adds the matches of the \a batch. Matches are only created for entries of the batch
+     * that are not discarded right away, for example because the runner already provided
+     * its maximum number of results.
+     *
+     * \since 6.29
+     */
+    bool addMatches(const QueryMatchBatch &batch);
+
     /*!
      * Appends a match to the existing list of matches.
      *
@@ -85,10 +106,18 @@ public:
      */
     bool addMatch(const QueryMatch &match);
 
+    /*!
+     * \overload
+     *
+     * \since 6.29
+     */
+    bool addMatch(QueryMatch &&match);
+
     /*!
      * Retrieves all available matches for the current search term.
      *
-     * Returns a list of matches
+     * Returns a list of matches, sorted descending by their category relevance and relevance.
+     * Matches that compare equal are kept in the order in which they were added.
      */
     QList<QueryMatch> matches() const;
 
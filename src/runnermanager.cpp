@@ -28,6 +28,7 @@
 #include "dbusrunner_p.h"
 #include "kpluginmetadata_utils_p.h"
 #include "krunner_debug.h"
+#include "localsocketrunner_p.h"
 #include "querymatch.h"
 
 namespace KRunner
@@ -121,7 +122,8 @@ public:
     void deleteRunners(const QList<AbstractRunner *> &runners)
     {
         for (const auto runner : runners) {
-            if (qobject_cast<DBusRunner *>(runner)) {
+            if (qobject_cast<DBusRunner *>(runner) || qobject_cast<LocalSocketRunner *>(runner)) {
+                // Deleted on the shared thread, which is stopped together with the manager
                 runner->deleteLater();
             } else {
                 Q_ASSERT(runner->thread() != q->thread());
@@ -191,6 +193,11 @@ public:
             }
         } else if (api.startsWith(QLatin1String("DBus"))) {
             runner = new DBusRunner(q, pluginMetaData);
+            // DBus runners mostly wait for replies, they share a thread where the replies get converted to matches
+            runner->moveToThread(remoteRunnerThread());
+        } else if (api == QLatin1String("LocalSocket")) {
+            runner = new LocalSocketRunner(q, pluginMetaData);
+            runner->moveToThread(remoteRunnerThread());
         } else {
             qCWarning(KRUNNER) << "Unknown X-Plasma-API requested for runner" << pluginMetaData.fileName();
             return nullptr;
@@ -222,6 +229,16 @@ public:
         return runner;
     }
 
+    QThread *remoteRunnerThread()
+    {
+        if (!remoteThread) {
+            remoteThread = new QThread();
+            remoteThread->setObjectName(QStringLiteral("RemoteRunners"));
+            remoteThread->start();
+        }
+        return remoteThread;
+    }
+
     void onRunnerJobFinished(const QString &jobId)
     {
         if (currentJobs.remove(jobId) && currentJobs.isEmpty()) {
@@ -370,6 +387,7 @@ public:
     QHash<QString, AbstractRunner *> runners;
     QHash<AbstractRunner *, QString> pendingJobsAfterSuspend;
     AbstractRunner *currentSingleRunner = nullptr;
+    QThread *remoteThread = nullptr;
     QSet<QString> currentJobs;
     QString singleModeRunnerId;
     bool prepped = false;
@@ -409,6 +427,13 @@ RunnerManager::~RunnerManager()
 {
     d->context.reset();
     d->deleteRunners(d->runners.values());
+    if (d->remoteThread) {
+        // Pending deletions of the remote runners are processed before the thread finishes. Their handlers only
+        // dispatch replies and never block, so waiting for them is cheap. Afterwards nothing references the thread anymore
+        d->remoteThread->quit();
+        d->remoteThread->wait();
+        delete d->remoteThread;
+    }
 }
 
 void RunnerManager::reloadConfiguration()
@@ -673,6 +698,15 @@ void RunnerManager::reset()
         d->currentJobs.clear();
     }
     d->context.reset();
+
+    // Remote runners can stop working on the queries of the previous context
+    for (AbstractRunner *runner : std::as_const(d->runners)) {
+        if (auto dbusRunner = qobject_cast<DBusRunner *>(runner)) {
+            QMetaObject::invokeMethod(dbusRunner, &DBusRunner::cancelOutdatedQueries, Qt::QueuedConnection);
+        } else if (auto socketRunner = qobject_cast<LocalSocketRunner *>(runner)) {
+            QMetaObject::invokeMethod(socketRunner, &LocalSocketRunner::cancelOutdatedQueries, Qt::QueuedConnection);
+        }
+    }
 }
 
 KPluginMetaData RunnerManager::convertDBusRunnerToJson(const QString &filename) const